@@ -25,6 +25,7 @@
 /// Truth evaluation includes
 #include <g4eval/JetEvalStack.h>
 #include <g4eval/SvtxEvalStack.h>
+#include <g4eval/SvtxTrackEval.h>
 
 /// HEPMC truth includes
 #include <HepMC/GenEvent.h>
@@ -32,6 +33,15 @@
 #include <phhepmc/PHHepMCGenEvent.h>
 #include <phhepmc/PHHepMCGenEventMap.h>
 
+/// Analysis utilities
+#include <anautils/ClusterKinematics.h>
+#include <anautils/ColumnTree.h>
+#include <anautils/EtaPhiGrid.h>
+#include <anautils/EventIndex.h>
+#include <anautils/OutputPolicy.h>
+#include <anautils/RowBuffer.h>
+#include <anautils/ThreadPool.h>
+
 /// Fun4All includes
 #include <fun4all/Fun4AllHistoManager.h>
 #include <fun4all/Fun4AllReturnCodes.h>
@@ -42,15 +52,19 @@
 #include <phool/getClass.h>
 
 /// ROOT includes
+#include <RVersion.h>
 #include <TFile.h>
 #include <TH1.h>
 #include <TH2.h>
 #include <TMath.h>
 #include <TNtuple.h>
+#include <TROOT.h>
 #include <TTree.h>
 
 /// C++ includes
+#include <algorithm>
 #include <cassert>
+#include <functional>
 #include <sstream>
 #include <string>
 
@@ -69,6 +83,7 @@ using namespace std;
 AnaTutorial::AnaTutorial(const std::string &name, const std::string &filename)
   : SubsysReco(name)
   , m_outfilename(filename)
+  , m_outputPolicy(new OutputPolicy())
   , m_hm(nullptr)
   , m_minjetpt(5.0)
   , m_mincluspt(0.25)
@@ -76,11 +91,57 @@ AnaTutorial::AnaTutorial(const std::string &name, const std::string &filename)
   , m_analyzeClusters(true)
   , m_analyzeJets(true)
   , m_analyzeTruth(false)
+  , m_doTrackEvalCaching(true)
+  , m_hepmcFinalStateOnly(false)
+  , m_hepmcMinEta(-1e10)
+  , m_hepmcMaxEta(1e10)
+  , m_hepmcMinPt(0)
+  , m_hepmcParticlesSeen(0)
+  , m_hepmcParticlesKept(0)
+  , m_nThreads(0)
+  , m_threadPool(nullptr)
+  , m_svtxEvalStack(nullptr)
+  , m_columnarOutput(false)
+  , m_eventtree(nullptr)
+  , m_clustercolumns(nullptr)
+  , m_trackcolumns(nullptr)
+  , m_hepmccolumns(nullptr)
+  , m_hepmceventcolumns(nullptr)
+  , m_truthcolumns(nullptr)
+  , m_recojetcolumns(nullptr)
+  , m_truthjetcolumns(nullptr)
+  , m_jetMatchOneToOne(false)
+  , m_truthJetGrid(nullptr)
+  , m_fillEventIndex(false)
+  , m_eventIndex(nullptr)
+  , m_njetsScalar(-1)
+  , m_maxClusPtScalar(-1)
+  , m_recoJetFlag(-1)
+  , m_clusterFlag(-1)
+  , m_maxcluspt(0)
+  , m_clusterAllVertices(false)
+  , m_clusterKinematics(new ClusterKinematics())
+  , m_hepmcEventMapNode("PHHepMCGenEventMap")
+  , m_truthInfoNode("G4TruthInfo")
+  , m_trackMapNode("SvtxTrackMap")
+  , m_truthJetNode("AntiKt_Truth_r04")
+  , m_recoJetNode("AntiKt_Tower_r04")
+  , m_clusterNode("CLUSTER_CEMC")
+  , m_vertexMapNode("GlobalVertexMap")
+  , m_triggerNode("CaloTriggerInfo")
+  , m_nodes()
+  , m_clustertree(nullptr)
+  , m_tracktree(nullptr)
+  , m_hepmctree(nullptr)
+  , m_hepmceventtree(nullptr)
+  , m_truthtree(nullptr)
+  , m_recojettree(nullptr)
+  , m_truthjettree(nullptr)
 {
-  /// Initialize variables and trees so we don't accidentally access 
-  /// memory that was never allocated
+  /// Initialize variables so we don't accidentally access
+  /// memory that was never allocated. The trees are created in Init
+  /// once the output file is open
   initializeVariables();
-  initializeTrees();
 }
 
 /**
@@ -89,7 +150,21 @@ AnaTutorial::AnaTutorial(const std::string &name, const std::string &filename)
 AnaTutorial::~AnaTutorial()
 {
   delete m_hm;
+  delete m_outputPolicy;
+  delete m_svtxEvalStack;
+  delete m_truthJetGrid;
+  delete m_clusterKinematics;
+  delete m_threadPool;
+  for (unsigned int i = 0; i < m_stagedTrees.size(); i++)
+  {
+    delete m_stagedTrees[i].rows;
+  }
+  delete m_eventtree;
+  /// Trees written to the outfile were deleted with it in End
+  delete m_clustertree;
   delete m_hepmctree;
+  delete m_hepmceventtree;
+  delete m_truthtree;
   delete m_truthjettree;
   delete m_recojettree;
   delete m_tracktree;
@@ -109,13 +184,121 @@ int AnaTutorial::Init(PHCompositeNode *topNode)
   // create and register your histos (all types) here
   // TH1 *h1 = new TH1F("h1",....)
   // hm->registerHisto(h1);
-  m_outfile = new TFile(m_outfilename.c_str(), "RECREATE");
+  m_outfile = m_outputPolicy->OpenFile(m_outfilename);
+
+  /// The trees are created in the open outfile, so their branches get
+  /// its compression and their baskets are written out while running
+  initializeTrees();
 
   m_phi_h = new TH1D("phi_h", ";Counts;#phi [rad]", 50, -6, 6);
   m_hm->registerHisto(m_phi_h);
   m_eta_phi_h = new TH2F("phi_eta_h", ";#eta;#phi [rad]", 10, -1, 1, 50, -6, 6);
   m_hm->registerHisto(m_eta_phi_h);
 
+  /// The columnar tree is created in the output file so its baskets
+  /// are written out while running
+  if (m_columnarOutput)
+  {
+    /// The flat trees only describe the branches of the collections here
+    TTree *flattrees[] = {m_clustertree, m_tracktree, m_hepmctree, m_hepmceventtree,
+                          m_truthtree, m_recojettree, m_truthjettree};
+    for (unsigned int i = 0; i < sizeof(flattrees) / sizeof(flattrees[0]); i++)
+    {
+      flattrees[i]->SetDirectory(nullptr);
+    }
+    initializeColumnTree();
+    m_outputPolicy->ApplyTo(m_eventtree->GetTree());
+  }
+  else
+  {
+    m_outputPolicy->ApplyTo(m_clustertree);
+    m_outputPolicy->ApplyTo(m_tracktree);
+    m_outputPolicy->ApplyTo(m_hepmctree);
+    m_outputPolicy->ApplyTo(m_hepmceventtree);
+    m_outputPolicy->ApplyTo(m_truthtree);
+    m_outputPolicy->ApplyTo(m_recojettree);
+    m_outputPolicy->ApplyTo(m_truthjettree);
+  }
+
+  /// The collections are extracted in parallel into row buffers, the
+  /// trees are only filled from this thread
+  if (m_nThreads > 1)
+  {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 0, 0)
+    ROOT::EnableThreadSafety();
+#endif
+    m_threadPool = new ThreadPool(m_nThreads);
+    initializeStagedTrees();
+  }
+
+  /// Per event summary for fast skims of the DSTs written by this job
+  if (m_fillEventIndex)
+  {
+    m_eventIndex = EventIndex::GetOrCreate(topNode);
+    if (m_eventIndex)
+    {
+      if (m_analyzeJets)
+      {
+        m_njetsScalar = m_eventIndex->RegisterIntScalar("njets");
+        m_recoJetFlag = m_eventIndex->RegisterFlag("recojet");
+      }
+      if (m_analyzeClusters)
+      {
+        m_maxClusPtScalar = m_eventIndex->RegisterScalar("maxcluspt");
+        m_clusterFlag = m_eventIndex->RegisterFlag("cluster");
+      }
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * The HepMC whitelists are kept sorted for a binary search per particle
+ */
+void AnaTutorial::addHepMCStatus(int status)
+{
+  m_hepmcStatus.insert(lower_bound(m_hepmcStatus.begin(), m_hepmcStatus.end(), status), status);
+}
+
+void AnaTutorial::addHepMCPid(int pid)
+{
+  m_hepmcPids.insert(lower_bound(m_hepmcPids.begin(), m_hepmcPids.end(), pid), pid);
+}
+
+/**
+ * Copy the I/O settings used when opening the outfile and building the trees
+ */
+void AnaTutorial::setOutputPolicy(const OutputPolicy &policy)
+{
+  *m_outputPolicy = policy;
+}
+
+/**
+ * Initialize the run dependent objects. The track evaluation stack is
+ * built here once and only reset for each event, since building it
+ * for every event is expensive and leaks its truth association caches
+ */
+int AnaTutorial::InitRun(PHCompositeNode *topNode)
+{
+  /// Look up the nodes once, the string search through the node tree
+  /// is too slow to do it for every event
+  m_hepmcEventMapNode.Resolve(topNode);
+  m_truthInfoNode.Resolve(topNode);
+  m_trackMapNode.Resolve(topNode);
+  m_truthJetNode.Resolve(topNode);
+  m_recoJetNode.Resolve(topNode);
+  m_clusterNode.Resolve(topNode);
+  m_vertexMapNode.Resolve(topNode);
+  m_triggerNode.Resolve(topNode);
+
+  if (m_analyzeTracks)
+  {
+    delete m_svtxEvalStack;
+    m_svtxEvalStack = new SvtxEvalStack(topNode);
+    m_svtxEvalStack->get_track_eval()->do_caching(m_doTrackEvalCaching);
+  }
+
   return 0;
 }
 
@@ -129,29 +312,60 @@ int AnaTutorial::process_event(PHCompositeNode *topNode)
   {
     cout << "Beginning process_event in AnaTutorial" << endl;
   }
-  /// Get the truth information
-  if (m_analyzeTruth)
+  m_eventnumber++;
+
+  getNodes(topNode);
+  if (m_threadPool)
   {
-    getHEPMCTruth(topNode);
-    getPHG4Truth(topNode);
+    extractParallel(topNode);
   }
-
-  /// Get the tracks
-  if (m_analyzeTracks)
+  else
   {
-    getTracks(topNode);
+    /// Get the truth information
+    if (m_analyzeTruth)
+    {
+      getHEPMCTruth(topNode);
+      getPHG4Truth(topNode);
+    }
+
+    /// Get the tracks
+    if (m_analyzeTracks)
+    {
+      getTracks(topNode);
+    }
+    /// Get the truth and reconstructed jets
+    if (m_analyzeJets)
+    {
+      getTruthJets(topNode);
+      getReconstructedJets(topNode);
+    }
+
+    /// Get calorimeter information
+    if (m_analyzeClusters)
+    {
+      getEMCalClusters(topNode);
+    }
   }
-  /// Get the truth and reconstructed jets
-  if (m_analyzeJets)
+
+  /// Summary of this event for the event index
+  if (m_eventIndex)
   {
-    getTruthJets(topNode);
-    getReconstructedJets(topNode);
+    if (m_analyzeJets)
+    {
+      m_eventIndex->SetIntScalar(m_njetsScalar, m_matchRecoJets.size());
+      m_eventIndex->SetFlag(m_recoJetFlag, !m_matchRecoJets.empty());
+    }
+    if (m_analyzeClusters)
+    {
+      m_eventIndex->SetScalar(m_maxClusPtScalar, m_maxcluspt);
+      m_eventIndex->SetFlag(m_clusterFlag, m_maxcluspt > 0);
+    }
   }
 
-  /// Get calorimeter information
-  if (m_analyzeClusters)
+  /// Write all objects of this event as one entry
+  if (m_eventtree)
   {
-    getEMCalClusters(topNode);
+    m_eventtree->Fill();
   }
 
   return Fun4AllReturnCodes::EVENT_OK;
@@ -170,28 +384,40 @@ int AnaTutorial::End(PHCompositeNode *topNode)
   /// Change to the outfile
   m_outfile->cd();
 
-  /// If we analyzed the tracks, write the tree out
-  if (m_analyzeTracks)
-    m_tracktree->Write();
-
-  /// If we analyzed the jets, write them out
-  if (m_analyzeJets)
+  /// In columnar mode all collections went into the per event tree which
+  /// lives in the outfile and is written with it below
+  if (!m_eventtree)
   {
-    m_truthjettree->Write();
-    m_recojettree->Write();
-  }
+    /// If we analyzed the tracks, write the tree out
+    if (m_analyzeTracks)
+      m_tracktree->Write();
 
-  /// If we analyzed the truth particles, write them out
-  if (m_analyzeTruth)
-  {
-    m_hepmctree->Write();
-    m_truthtree->Write();
+    /// If we analyzed the jets, write them out
+    if (m_analyzeJets)
+    {
+      m_truthjettree->Write();
+      m_recojettree->Write();
+    }
+
+    /// If we analyzed the truth particles, write them out
+    if (m_analyzeTruth)
+    {
+      m_hepmctree->Write();
+      m_hepmceventtree->Write();
+      m_truthtree->Write();
+    }
+
+    /// If we analyzed the clusters, write them out
+    if (m_analyzeClusters)
+    {
+      m_clustertree->Write();
+    }
   }
 
-  /// If we analyzed the clusters, write them out
-  if (m_analyzeClusters)
+  if (m_analyzeTruth)
   {
-    m_clustertree->Write();
+    cout << "AnaTutorial: kept " << m_hepmcParticlesKept << " of "
+         << m_hepmcParticlesSeen << " HepMC particles" << endl;
   }
 
   /// Write out any other histograms
@@ -203,9 +429,25 @@ int AnaTutorial::End(PHCompositeNode *topNode)
   m_outfile->Close();
 
   delete m_outfile;
+  m_outfile = nullptr;
+
+  /// Closing the outfile deleted the trees which were written to it
+  if (!m_eventtree)
+  {
+    m_clustertree = nullptr;
+    m_tracktree = nullptr;
+    m_hepmctree = nullptr;
+    m_hepmceventtree = nullptr;
+    m_truthtree = nullptr;
+    m_recojettree = nullptr;
+    m_truthjettree = nullptr;
+  }
 
   /// Let the histogram manager deal with dumping the histogram memory
-  m_hm->dumpHistos(m_outfilename, "UPDATE");
+  m_hm->dumpHistos(m_outputPolicy->LocalFileName(m_outfilename), "UPDATE");
+
+  /// Move the outfile from the scratch area if one was used
+  m_outputPolicy->Finish(m_outfilename);
 
   if (Verbosity() > 1)
   {
@@ -215,6 +457,78 @@ int AnaTutorial::End(PHCompositeNode *topNode)
   return 0;
 }
 
+/**
+ * NodeHandle::Get updates its cache if a node was replaced and looks up
+ * nodes which were missing so far. This writes to the handle, so it is
+ * done here on the main thread once per event and the extraction
+ * functions (the truth info is used by the truth and the track
+ * extraction) only read the pointers
+ */
+void AnaTutorial::getNodes(PHCompositeNode *topNode)
+{
+  m_nodes.hepmcEventMap = m_hepmcEventMapNode.Get(topNode);
+  m_nodes.truthInfo = m_truthInfoNode.Get(topNode);
+  m_nodes.trackMap = m_trackMapNode.Get(topNode);
+  m_nodes.truthJets = m_truthJetNode.Get(topNode);
+  m_nodes.recoJets = m_recoJetNode.Get(topNode);
+  m_nodes.clusters = m_clusterNode.Get(topNode);
+  m_nodes.vertexMap = m_vertexMapNode.Get(topNode);
+  m_nodes.trigger = m_triggerNode.Get(topNode);
+}
+
+/**
+ * The four extractions read different nodes and write different member
+ * variables and trees, so they can run at the same time. Inside the tasks
+ * fillObject only copies the variables into the row buffer of the tree,
+ * the trees are filled here afterwards in the order the rows were made
+ */
+void AnaTutorial::extractParallel(PHCompositeNode *topNode)
+{
+  /// The track-truth evaluation is usually the slowest, start it first
+  vector<function<void()> > tasks;
+  if (m_analyzeTracks)
+  {
+    tasks.push_back([this, topNode] { getTracks(topNode); });
+  }
+  if (m_analyzeTruth)
+  {
+    tasks.push_back([this, topNode] {
+      getHEPMCTruth(topNode);
+      getPHG4Truth(topNode);
+    });
+  }
+  if (m_analyzeJets)
+  {
+    tasks.push_back([this, topNode] {
+      getTruthJets(topNode);
+      getReconstructedJets(topNode);
+    });
+  }
+  if (m_analyzeClusters)
+  {
+    tasks.push_back([this, topNode] { getEMCalClusters(topNode); });
+  }
+  m_threadPool->Run(tasks);
+
+  for (unsigned int i = 0; i < m_stagedTrees.size(); i++)
+  {
+    StagedTree &staged = m_stagedTrees[i];
+    for (unsigned int row = 0; row < staged.rows->Rows(); row++)
+    {
+      staged.rows->Restore(row);
+      if (staged.columns)
+      {
+        staged.columns->AppendRow();
+      }
+      else
+      {
+        staged.tree->Fill();
+      }
+    }
+    staged.rows->Clear();
+  }
+}
+
 /**
  * This method gets all of the HEPMC truth particles from the node tree
  * and stores them in a ROOT TTree. The HEPMC truth particles are what, 
@@ -224,7 +538,7 @@ int AnaTutorial::End(PHCompositeNode *topNode)
 void AnaTutorial::getHEPMCTruth(PHCompositeNode *topNode)
 {
   /// Get the node from the node tree
-  PHHepMCGenEventMap *hepmceventmap = findNode::getClass<PHHepMCGenEventMap>(topNode, "PHHepMCGenEventMap");
+  PHHepMCGenEventMap *hepmceventmap = m_nodes.hepmcEventMap;
 
   /// If the node was not properly put on the tree, return
   if (!hepmceventmap)
@@ -262,14 +576,26 @@ void AnaTutorial::getHEPMCTruth(PHCompositeNode *topNode)
         return;
       }
 
-      /// Get the parton info
-      HepMC::PdfInfo *pdfinfo = truthevent->pdf_info();
+      /// Event characteristics, written once per GenEvent into the
+      /// hepmceventtree instead of with every particle
+      m_hepmcid = eventIter->first;
 
       /// Get the parton info as determined from HEPMC
-      m_partid1 = pdfinfo->id1();
-      m_partid2 = pdfinfo->id2();
-      m_x1 = pdfinfo->x1();
-      m_x2 = pdfinfo->x2();
+      HepMC::PdfInfo *pdfinfo = truthevent->pdf_info();
+      if (pdfinfo)
+      {
+        m_partid1 = pdfinfo->id1();
+        m_partid2 = pdfinfo->id2();
+        m_x1 = pdfinfo->x1();
+        m_x2 = pdfinfo->x2();
+      }
+      else
+      {
+        m_partid1 = -99;
+        m_partid2 = -99;
+        m_x1 = -99;
+        m_x2 = -99;
+      }
 
       /// Are there multiple partonic intercations in a p+p event
       m_mpi = truthevent->mpi();
@@ -277,30 +603,69 @@ void AnaTutorial::getHEPMCTruth(PHCompositeNode *topNode)
       /// Get the PYTHIA signal process id identifying the 2-to-2 hard process
       m_process_id = truthevent->signal_process_id();
 
+      m_numparticlesinevent = 0;
+      m_numkeptparticles = 0;
+
       if (Verbosity() > 2)
       {
         cout << " Iterating over an event" << endl;
       }
+      /// The filters are applied before anything is computed for the
+      /// particle, cheapest first. The pT cut compares squares
+      const bool statusFilter = !m_hepmcStatus.empty();
+      const bool pidFilter = !m_hepmcPids.empty();
+      const bool etaFilter = m_hepmcMinEta > -1e10 || m_hepmcMaxEta < 1e10;
+      const double minpt2 = m_hepmcMinPt * m_hepmcMinPt;
+
       /// Loop over all the truth particles and get their information
       for (HepMC::GenEvent::particle_const_iterator iter = truthevent->particles_begin();
            iter != truthevent->particles_end();
            ++iter)
       {
-        /// Get each pythia particle characteristics
-        m_truthenergy = (*iter)->momentum().e();
-        m_truthpid = (*iter)->pdg_id();
+        const HepMC::GenParticle *particle = *iter;
+        m_numparticlesinevent++;
+
+        const int status = particle->status();
+        if (m_hepmcFinalStateOnly && status != 1)
+          continue;
+        if (statusFilter && !binary_search(m_hepmcStatus.begin(), m_hepmcStatus.end(), status))
+          continue;
 
-        m_trutheta = (*iter)->momentum().pseudoRapidity();
-        m_truthphi = (*iter)->momentum().phi();
-        m_truthpx = (*iter)->momentum().px();
-        m_truthpy = (*iter)->momentum().py();
-        m_truthpz = (*iter)->momentum().pz();
-        m_truthpt = sqrt(m_truthpx * m_truthpx + m_truthpy * m_truthpy);
+        const int pid = particle->pdg_id();
+        if (pidFilter && !binary_search(m_hepmcPids.begin(), m_hepmcPids.end(), pid))
+          continue;
+
+        const HepMC::FourVector &momentum = particle->momentum();
+        const double pt2 = momentum.perp2();
+        if (pt2 < minpt2)
+          continue;
+
+        if (etaFilter)
+        {
+          const double eta = momentum.pseudoRapidity();
+          if (eta < m_hepmcMinEta || eta > m_hepmcMaxEta)
+            continue;
+        }
+
+        /// Get each pythia particle characteristics
+        m_truthstatus = status;
+        m_truthpid = pid;
+        m_truthenergy = momentum.e();
+        m_trutheta = momentum.pseudoRapidity();
+        m_truthphi = momentum.phi();
+        m_truthpx = momentum.px();
+        m_truthpy = momentum.py();
+        m_truthpz = momentum.pz();
+        m_truthpt = sqrt(pt2);
 
         /// Fill the truth tree
-        m_hepmctree->Fill();
-        m_numparticlesinevent++;
+        fillObject(m_hepmctree, m_hepmccolumns);
+        m_numkeptparticles++;
       }
+
+      m_hepmcParticlesSeen += m_numparticlesinevent;
+      m_hepmcParticlesKept += m_numkeptparticles;
+      fillObject(m_hepmceventtree, m_hepmceventcolumns);
     }
   }
 }
@@ -314,7 +679,7 @@ void AnaTutorial::getHEPMCTruth(PHCompositeNode *topNode)
 void AnaTutorial::getPHG4Truth(PHCompositeNode *topNode)
 {
   /// G4 truth particle node
-  PHG4TruthInfoContainer *truthinfo = findNode::getClass<PHG4TruthInfoContainer>(topNode, "G4TruthInfo");
+  PHG4TruthInfoContainer *truthinfo = m_nodes.truthInfo;
 
   if (!truthinfo)
   {
@@ -353,7 +718,7 @@ void AnaTutorial::getPHG4Truth(PHCompositeNode *topNode)
     m_truthpid = truth->get_pid();
 
     /// Fill the g4 truth tree
-    m_truthtree->Fill();
+    fillObject(m_truthtree, m_truthcolumns);
   }
 }
 
@@ -365,7 +730,7 @@ void AnaTutorial::getPHG4Truth(PHCompositeNode *topNode)
 void AnaTutorial::getTracks(PHCompositeNode *topNode)
 {
   /// SVTX tracks node
-  SvtxTrackMap *trackmap = findNode::getClass<SvtxTrackMap>(topNode, "SvtxTrackMap");
+  SvtxTrackMap *trackmap = m_nodes.trackMap;
 
   if (!trackmap)
   {
@@ -375,15 +740,23 @@ void AnaTutorial::getTracks(PHCompositeNode *topNode)
     return;
   }
 
-  /// EvalStack for truth track matching
-  SvtxEvalStack *svtxevalstack = new SvtxEvalStack(topNode);
-  svtxevalstack->next_event(topNode);
+  if (!m_svtxEvalStack)
+  {
+    cout << PHWHERE
+         << "SvtxEvalStack was not created in InitRun, can't match tracks to truth"
+         << endl;
+    return;
+  }
+
+  /// Reset the EvalStack for truth track matching, this clears the
+  /// truth association caches filled in the previous event
+  m_svtxEvalStack->next_event(topNode);
 
   /// Get the track evaluator
-  SvtxTrackEval *trackeval = svtxevalstack->get_track_eval();
+  SvtxTrackEval *trackeval = m_svtxEvalStack->get_track_eval();
 
   /// Get the range for primary tracks
-  PHG4TruthInfoContainer *truthinfo = findNode::getClass<PHG4TruthInfoContainer>(topNode, "G4TruthInfo");
+  PHG4TruthInfoContainer *truthinfo = m_nodes.truthInfo;
 
   if (Verbosity() > 1)
   {
@@ -420,6 +793,8 @@ void AnaTutorial::getTracks(PHCompositeNode *topNode)
 
     /// Get truth track info that matches this reconstructed track
     PHG4Particle *truthtrack = trackeval->max_truth_particle_by_nclusters(track);
+    if (!truthtrack)
+      continue;
     m_truth_is_primary = truthinfo->is_primary(truthtrack);
 
     m_truthtrackpx = truthtrack->get_px();
@@ -434,7 +809,7 @@ void AnaTutorial::getTracks(PHCompositeNode *topNode)
     m_truthtracketa = atanh(m_truthtrackpz / m_truthtrackp);
     m_truthtrackpid = truthtrack->get_pid();
 
-    m_tracktree->Fill();
+    fillObject(m_tracktree, m_trackcolumns);
   }
 }
 
@@ -449,7 +824,7 @@ void AnaTutorial::getTruthJets(PHCompositeNode *topNode)
   }
 
   /// Get the truth jet node
-  JetMap *truth_jets = findNode::getClass<JetMap>(topNode, "AntiKt_Truth_r04");
+  JetMap *truth_jets = m_nodes.truthJets;
 
   if (!truth_jets)
   {
@@ -481,7 +856,7 @@ void AnaTutorial::getTruthJets(PHCompositeNode *topNode)
     m_truthjetenergy = jet->get_e();
 
     /// Fill the truthjet tree
-    m_truthjettree->Fill();
+    fillObject(m_truthjettree, m_truthjetcolumns);
   }
 }
 
@@ -491,9 +866,10 @@ void AnaTutorial::getTruthJets(PHCompositeNode *topNode)
 void AnaTutorial::getReconstructedJets(PHCompositeNode *topNode)
 {
   /// Get the reconstructed tower jets
-  JetMap *reco_jets = findNode::getClass<JetMap>(topNode, "AntiKt_Tower_r04");
+  JetMap *reco_jets = m_nodes.recoJets;
   /// Get the truth jets
-  JetMap *truth_jets = findNode::getClass<JetMap>(topNode, "AntiKt_Truth_r04");
+  JetMap *truth_jets = m_nodes.truthJets;
+  m_matchRecoJets.clear();
 
   if (!reco_jets)
   {
@@ -508,19 +884,83 @@ void AnaTutorial::getReconstructedJets(PHCompositeNode *topNode)
     cout << "Get all Reco Jets" << endl;
   }
 
-  /// Iterate over the reconstructed jets
+  /// Collect the reconstructed jets above threshold
+  m_matchRecoEta.clear();
+  m_matchRecoPhi.clear();
   for (JetMap::Iter recoIter = reco_jets->begin();
        recoIter != reco_jets->end();
        ++recoIter)
   {
     const Jet *recoJet = recoIter->second;
-    m_recojetpt = recoJet->get_pt();
-    if (m_recojetpt < m_minjetpt)
+    if (recoJet->get_pt() < m_minjetpt)
       continue;
 
-    m_recojeteta = recoJet->get_eta();
+    m_matchRecoJets.push_back(recoJet);
+    m_matchRecoEta.push_back(recoJet->get_eta());
+    m_matchRecoPhi.push_back(recoJet->get_phi());
+  }
+
+  /// Match the reconstructed jets to the closest truth jet in delta R space.
+  /// The truth jets are put into an eta-phi grid with cells of the size of
+  /// the jet parameter, so only truth jets in the neighbouring cells are
+  /// looked at
+  const float matchradius = reco_jets->get_par();
+  m_matchIndex.assign(m_matchRecoJets.size(), -1);
+  m_matchDR2.assign(m_matchRecoJets.size(), -99);
+
+  /// Check to make sure the truth jet node is available
+  if (truth_jets)
+  {
+    if (!m_truthJetGrid)
+    {
+      m_truthJetGrid = new EtaPhiGrid(matchradius);
+    }
+    else if (m_truthJetGrid->CellSize() != matchradius)
+    {
+      m_truthJetGrid->SetBinning(matchradius, -5., 5.);
+    }
+    m_truthJetGrid->Reset();
+    m_matchTruthJets.clear();
+
+    for (JetMap::Iter truthIter = truth_jets->begin();
+         truthIter != truth_jets->end();
+         ++truthIter)
+    {
+      const Jet *truthJet = truthIter->second;
+      if (truthJet->get_pt() < m_minjetpt)
+        continue;
+
+      m_truthJetGrid->Add(truthJet->get_eta(), truthJet->get_phi(), m_matchTruthJets.size());
+      m_matchTruthJets.push_back(truthJet);
+    }
+
+    m_truthJetGrid->Match(m_matchRecoEta, m_matchRecoPhi, matchradius,
+                          m_jetMatchOneToOne ? EtaPhiGrid::kOneToOneGreedy : EtaPhiGrid::kClosest,
+                          m_matchIndex, m_matchDR2);
+
+    /// Cross check the grid against looping over all truth jets
+    if (Verbosity() > 2 && !m_jetMatchOneToOne)
+    {
+      for (unsigned int i = 0; i < m_matchRecoJets.size(); i++)
+      {
+        float dr2 = 0;
+        int bruteforce = m_truthJetGrid->FindClosestBruteForce(m_matchRecoEta[i], m_matchRecoPhi[i], matchradius, dr2);
+        if (bruteforce != m_matchIndex[i])
+        {
+          cout << PHWHERE << " jet matching mismatch for reco jet " << m_matchRecoJets[i]->get_id()
+               << ": grid " << m_matchIndex[i] << ", brute force " << bruteforce << endl;
+        }
+      }
+    }
+  }
+
+  for (unsigned int i = 0; i < m_matchRecoJets.size(); i++)
+  {
+    const Jet *recoJet = m_matchRecoJets[i];
 
     // Get reco jet characteristics
+    m_recojetpt = recoJet->get_pt();
+    m_recojeteta = recoJet->get_eta();
     m_recojetid = recoJet->get_id();
     m_recojetpx = recoJet->get_px();
     m_recojetpy = recoJet->get_py();
@@ -529,11 +969,6 @@ void AnaTutorial::getReconstructedJets(PHCompositeNode *topNode)
     m_recojetp = recoJet->get_p();
     m_recojetenergy = recoJet->get_e();
 
-    if (Verbosity() > 1)
-    {
-      cout << "matching by distance jet" << endl;
-    }
-
     /// Set the matched truth jet characteristics to 0
     m_truthjetid = 0;
     m_truthjetp = 0;
@@ -544,55 +979,24 @@ void AnaTutorial::getReconstructedJets(PHCompositeNode *topNode)
     m_truthjetpx = 0;
     m_truthjetpy = 0;
     m_truthjetpz = 0;
+    m_dR = -99;
 
-    /// Check to make sure the truth jet node is available
-    if (truth_jets)
+    if (m_matchIndex[i] >= 0)
     {
-      /// Match the reconstructed jet to the closest truth jet in delta R space
-      /// Iterate over the truth jets
-      float closestjet = 9999;
-      for (JetMap::Iter truthIter = truth_jets->begin();
-           truthIter != truth_jets->end();
-           ++truthIter)
-      {
-        const Jet *truthJet = truthIter->second;
-
-        float thisjetpt = truthJet->get_pt();
-        if (thisjetpt < m_minjetpt)
-          continue;
-
-        float thisjeteta = truthJet->get_eta();
-        float thisjetphi = truthJet->get_phi();
-
-        float dphi = m_recojetphi - thisjetphi;
-        if (dphi > 3. * TMath::Pi() / 2.)
-          dphi -= TMath::Pi() * 2.;
-        if (dphi < -1. * TMath::Pi() / 2.)
-          dphi += TMath::Pi() * 2.;
-
-        float deta = m_recojeteta - thisjeteta;
-        /// Determine the distance in eta phi space between the reconstructed
-        /// and truth jets
-        m_dR = sqrt(pow(dphi, 2.) + pow(deta, 2.));
-
-        /// If this truth jet is closer than the previous truth jet, it is
-        /// closer and thus should be considered the truth jet
-        if (m_dR < reco_jets->get_par() && m_dR < closestjet)
-        {
-          m_truthjetid = -9999;
-          m_truthjetp = truthJet->get_p();
-          m_truthjetphi = truthJet->get_phi();
-          m_truthjeteta = truthJet->get_eta();
-          m_truthjetpt = truthJet->get_pt();
-          m_truthjetenergy = truthJet->get_e();
-          m_truthjetpx = truthJet->get_px();
-          m_truthjetpy = truthJet->get_py();
-          m_truthjetpz = truthJet->get_pz();
-          closestjet = m_dR;
-        }
-      }
+      const Jet *truthJet = m_matchTruthJets[m_matchIndex[i]];
+      m_truthjetid = -9999;
+      m_truthjetp = truthJet->get_p();
+      m_truthjetphi = truthJet->get_phi();
+      m_truthjeteta = truthJet->get_eta();
+      m_truthjetpt = truthJet->get_pt();
+      m_truthjetenergy = truthJet->get_e();
+      m_truthjetpx = truthJet->get_px();
+      m_truthjetpy = truthJet->get_py();
+      m_truthjetpz = truthJet->get_pz();
+      /// Only the matched pair needs the square root
+      m_dR = sqrt(m_matchDR2[i]);
     }
-    m_recojettree->Fill();
+    fillObject(m_recojettree, m_recojetcolumns);
   }
 }
 
@@ -607,7 +1011,8 @@ void AnaTutorial::getEMCalClusters(PHCompositeNode *topNode)
   /// Get the raw cluster container
   /// Note: other cluster containers exist as well. Check out the node tree when
   /// you run a simulation
-  RawClusterContainer *clusters = findNode::getClass<RawClusterContainer>(topNode, "CLUSTER_CEMC");
+  RawClusterContainer *clusters = m_nodes.clusters;
+  m_maxcluspt = 0;
 
   if (!clusters)
   {
@@ -618,7 +1023,7 @@ void AnaTutorial::getEMCalClusters(PHCompositeNode *topNode)
   }
 
   /// Get the global vertex to determine the appropriate pseudorapidity of the clusters
-  GlobalVertexMap *vertexmap = findNode::getClass<GlobalVertexMap>(topNode, "GlobalVertexMap");
+  GlobalVertexMap *vertexmap = m_nodes.vertexMap;
   if (!vertexmap)
   {
     cout << "AnaTutorial::getEmcalClusters - Fatal Error - GlobalVertexMap node is missing. Please turn on the do_global flag in the main macro in order to reconstruct the global vertex." << endl;
@@ -633,47 +1038,64 @@ void AnaTutorial::getEMCalClusters(PHCompositeNode *topNode)
     return;
   }
 
-  GlobalVertex *vtx = vertexmap->begin()->second;
-  if (vtx == nullptr)
-    return;
-
-  /// Trigger emulator
-  CaloTriggerInfo *trigger = findNode::getClass<CaloTriggerInfo>(topNode, "CaloTriggerInfo");
+  /// Trigger emulator, not every DST has it
+  CaloTriggerInfo *trigger = m_nodes.trigger;
   /// Can obtain some trigger information if desired
-  m_E_4x4 = trigger->get_best_EMCal_4x4_E();
-
-  RawClusterContainer::ConstRange begin_end = clusters->getClusters();
-  RawClusterContainer::ConstIterator clusIter;
-
-  /// Loop over the EMCal clusters
-  for (clusIter = begin_end.first;
-       clusIter != begin_end.second;
-       ++clusIter)
-  {
-    /// Get this cluster
-    const RawCluster *cluster = clusIter->second;
-
-    /// Get cluster characteristics
-    /// This helper class determines the photon characteristics
-    /// depending on the vertex position
-    /// This is important for e.g. eta determination and E_T determination
-    CLHEP::Hep3Vector vertex(vtx->get_x(), vtx->get_y(), vtx->get_z());
-    CLHEP::Hep3Vector E_vec_cluster = RawClusterUtility::GetECoreVec(*cluster, vertex);
-    m_clusenergy = E_vec_cluster.mag();
-    m_cluseta = E_vec_cluster.pseudoRapidity();
-    m_clustheta = E_vec_cluster.getTheta();
-    m_cluspt = E_vec_cluster.perp();
-    m_clusphi = E_vec_cluster.getPhi();
-
-    if (m_cluspt < m_mincluspt)
+  m_clusvtxid = -99;
+  m_clusvtxz = -99;
+  m_E_4x4 = -99;
+  if (trigger)
+  {
+    m_E_4x4 = trigger->get_best_EMCal_4x4_E();
+  }
+  else if (Verbosity() > 1)
+  {
+    cout << PHWHERE << " CaloTriggerInfo node is missing, no 4x4 trigger energy" << endl;
+  }
+
+  /// Get cluster characteristics
+  /// The photon characteristics depend on the vertex position, this is
+  /// important for e.g. eta determination and E_T determination. The
+  /// cluster positions and energies are copied once per event, for each
+  /// vertex the momenta of all clusters are computed in one go (what
+  /// RawClusterUtility::GetECoreVec does for one cluster) and the pT cut is
+  /// applied before eta, theta and phi are calculated
+  m_clusterKinematics->Fill(clusters);
+
+  for (GlobalVertexMap::ConstIter vtxIter = vertexmap->begin();
+       vtxIter != vertexmap->end();
+       ++vtxIter)
+  {
+    const GlobalVertex *vtx = vtxIter->second;
+    if (vtx == nullptr)
       continue;
 
-    m_cluspx = m_cluspt * cos(m_clusphi);
-    m_cluspy = m_cluspt * sin(m_clusphi);
-    m_cluspz = sqrt(m_clusenergy * m_clusenergy - m_cluspx * m_cluspx - m_cluspy * m_cluspy);
+    m_clusvtxid = vtxIter->first;
+    m_clusvtxz = vtx->get_z();
+    const unsigned int nclusters = m_clusterKinematics->Compute(vtx->get_x(), vtx->get_y(), vtx->get_z(), m_mincluspt);
+
+    /// Loop over the EMCal clusters above threshold
+    for (unsigned int i = 0; i < nclusters; i++)
+    {
+      m_clusenergy = m_clusterKinematics->E(i);
+      m_cluseta = m_clusterKinematics->Eta(i);
+      m_clustheta = m_clusterKinematics->Theta(i);
+      m_cluspt = m_clusterKinematics->Pt(i);
+      m_clusphi = m_clusterKinematics->Phi(i);
+      m_cluspx = m_clusterKinematics->Px(i);
+      m_cluspy = m_clusterKinematics->Py(i);
+      m_cluspz = m_clusterKinematics->Pz(i);
+
+      if (m_cluspt > m_maxcluspt)
+        m_maxcluspt = m_cluspt;
+
+      //fill the cluster tree with all emcal clusters
+      fillObject(m_clustertree, m_clustercolumns);
+    }
 
-    //fill the cluster tree with all emcal clusters
-    m_clustertree->Fill();
+    /// By default only the first vertex is used
+    if (!m_clusterAllVertices)
+      break;
   }
 }
 
@@ -740,13 +1162,22 @@ void AnaTutorial::initializeTrees()
   m_tracktree->Branch("m_truthtracketa", &m_truthtracketa, "m_truthtracketa/D");
   m_tracktree->Branch("m_truthtrackpid", &m_truthtrackpid, "m_truthtrackpid/I");
 
+  m_hepmceventtree = new TTree("hepmceventtree", "A tree with the hepmc event information");
+  m_hepmceventtree->Branch("m_eventnumber", &m_eventnumber, "m_eventnumber/I");
+  m_hepmceventtree->Branch("m_hepmcid", &m_hepmcid, "m_hepmcid/I");
+  m_hepmceventtree->Branch("m_partid1", &m_partid1, "m_partid1/I");
+  m_hepmceventtree->Branch("m_partid2", &m_partid2, "m_partid2/I");
+  m_hepmceventtree->Branch("m_x1", &m_x1, "m_x1/D");
+  m_hepmceventtree->Branch("m_x2", &m_x2, "m_x2/D");
+  m_hepmceventtree->Branch("m_mpi", &m_mpi, "m_mpi/I");
+  m_hepmceventtree->Branch("m_process_id", &m_process_id, "m_process_id/I");
+  m_hepmceventtree->Branch("m_numparticlesinevent", &m_numparticlesinevent, "m_numparticlesinevent/I");
+  m_hepmceventtree->Branch("m_numkeptparticles", &m_numkeptparticles, "m_numkeptparticles/I");
+
   m_hepmctree = new TTree("hepmctree", "A tree with hepmc truth particles");
-  m_hepmctree->Branch("m_partid1", &m_partid1, "m_partid1/I");
-  m_hepmctree->Branch("m_partid2", &m_partid2, "m_partid2/I");
-  m_hepmctree->Branch("m_x1", &m_x1, "m_x1/D");
-  m_hepmctree->Branch("m_x2", &m_x2, "m_x2/D");
-  m_hepmctree->Branch("m_mpi", &m_mpi, "m_mpi/I");
-  m_hepmctree->Branch("m_process_id", &m_process_id, "m_process_id/I");
+  m_hepmctree->Branch("m_eventnumber", &m_eventnumber, "m_eventnumber/I");
+  m_hepmctree->Branch("m_hepmcid", &m_hepmcid, "m_hepmcid/I");
+  m_hepmctree->Branch("m_truthstatus", &m_truthstatus, "m_truthstatus/I");
   m_hepmctree->Branch("m_truthenergy", &m_truthenergy, "m_truthenergy/D");
   m_hepmctree->Branch("m_trutheta", &m_trutheta, "m_trutheta/D");
   m_hepmctree->Branch("m_truthphi", &m_truthphi, "m_truthphi/D");
@@ -754,7 +1185,6 @@ void AnaTutorial::initializeTrees()
   m_hepmctree->Branch("m_truthpy", &m_truthpy, "m_truthpy/D");
   m_hepmctree->Branch("m_truthpz", &m_truthpz, "m_truthpz/D");
   m_hepmctree->Branch("m_truthpt", &m_truthpt, "m_truthpt/D");
-  m_hepmctree->Branch("m_numparticlesinevent", &m_numparticlesinevent, "m_numparticlesinevent/I");
   m_hepmctree->Branch("m_truthpid", &m_truthpid, "m_truthpid/I");
 
   m_truthtree = new TTree("truthg4tree", "A tree with truth g4 particles");
@@ -777,9 +1207,92 @@ void AnaTutorial::initializeTrees()
   m_clustertree->Branch("m_cluspx", &m_cluspx, "m_cluspx/D");
   m_clustertree->Branch("m_cluspy", &m_cluspy, "m_cluspy/D");
   m_clustertree->Branch("m_cluspz", &m_cluspz, "m_cluspz/D");
+  m_clustertree->Branch("m_clusvtxid", &m_clusvtxid, "m_clusvtxid/I");
+  m_clustertree->Branch("m_clusvtxz", &m_clusvtxz, "m_clusvtxz/D");
   m_clustertree->Branch("m_E_4x4", &m_E_4x4, "m_E_4x4/D");
 }
 
+/**
+ * The columnar output stores the same variables as the flat trees above, so
+ * its collections are built from their branch lists. Everything ends up in
+ * one tree with one entry per event.
+ */
+void AnaTutorial::initializeColumnTree()
+{
+  m_eventtree = new ColumnTree("eventtree", "A tree with all collections of an event");
+  if (m_analyzeTruth)
+  {
+    m_hepmceventcolumns = m_eventtree->AddCollection("hepmcevent");
+    m_hepmceventcolumns->AddFromTree(m_hepmceventtree);
+    m_hepmccolumns = m_eventtree->AddCollection("hepmc");
+    m_hepmccolumns->AddFromTree(m_hepmctree);
+    m_truthcolumns = m_eventtree->AddCollection("truthg4");
+    m_truthcolumns->AddFromTree(m_truthtree);
+  }
+  if (m_analyzeTracks)
+  {
+    m_trackcolumns = m_eventtree->AddCollection("track");
+    m_trackcolumns->AddFromTree(m_tracktree);
+  }
+  if (m_analyzeJets)
+  {
+    m_truthjetcolumns = m_eventtree->AddCollection("truthjet");
+    m_truthjetcolumns->AddFromTree(m_truthjettree);
+    m_recojetcolumns = m_eventtree->AddCollection("recojet");
+    m_recojetcolumns->AddFromTree(m_recojettree);
+  }
+  if (m_analyzeClusters)
+  {
+    m_clustercolumns = m_eventtree->AddCollection("cluster");
+    m_clustercolumns->AddFromTree(m_clustertree);
+  }
+}
+
+/**
+ * One row buffer for every tree (and its column collection), bound to the
+ * same member variables as the tree
+ */
+void AnaTutorial::initializeStagedTrees()
+{
+  TTree *trees[] = {m_hepmctree, m_hepmceventtree, m_truthtree, m_tracktree,
+                    m_truthjettree, m_recojettree, m_clustertree};
+  ColumnCollection *columns[] = {m_hepmccolumns, m_hepmceventcolumns, m_truthcolumns, m_trackcolumns,
+                                 m_truthjetcolumns, m_recojetcolumns, m_clustercolumns};
+  for (unsigned int i = 0; i < sizeof(trees) / sizeof(trees[0]); i++)
+  {
+    StagedTree staged;
+    staged.tree = trees[i];
+    staged.columns = columns[i];
+    staged.rows = new RowBuffer(trees[i]);
+    m_stagedTrees.push_back(staged);
+  }
+}
+
+void AnaTutorial::fillObject(TTree *tree, ColumnCollection *columns)
+{
+  /// In the parallel extraction every tree is filled by one task only, so
+  /// its row buffer needs no lock
+  if (m_threadPool)
+  {
+    for (unsigned int i = 0; i < m_stagedTrees.size(); i++)
+    {
+      if (m_stagedTrees[i].tree == tree)
+      {
+        m_stagedTrees[i].rows->AppendRow();
+        return;
+      }
+    }
+  }
+  if (columns)
+  {
+    columns->AppendRow();
+  }
+  else
+  {
+    tree->Fill();
+  }
+}
+
 /**
  * This function initializes all of the member variables in this class so that there
  * are no variables that might not be set before e.g. writing them to the output
@@ -791,12 +1304,17 @@ void AnaTutorial::initializeVariables()
   m_phi_h = new TH1F();
   m_eta_phi_h = new TH2F();
 
+  m_eventnumber = -1;
+  m_hepmcid = -99;
   m_partid1 = -99;
   m_partid2 = -99;
   m_x1 = -99;
   m_x2 = -99;
   m_mpi = -99;
   m_process_id = -99;
+  m_numparticlesinevent = -99;
+  m_numkeptparticles = -99;
+  m_truthstatus = -99;
   m_truthenergy = -99;
   m_trutheta = -99;
   m_truthphi = -99;
@@ -805,7 +1323,6 @@ void AnaTutorial::initializeVariables()
   m_truthpy = -99;
   m_truthpz = -99;
   m_truthpt = -99;
-  m_numparticlesinevent = -99;
   m_truthpid = -99;
 
   m_tr_px = -99;
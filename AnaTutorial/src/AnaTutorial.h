@@ -3,6 +3,12 @@
 
 #include <fun4all/SubsysReco.h>
 
+#if !defined(__CINT__) || defined(__CLING__)
+#include <anautils/NodeHandle.h>
+
+#include <vector>
+#endif
+
 /// Class declarations for use in the analysis module
 class Fun4AllHistoManager;
 class PHCompositeNode;
@@ -16,6 +22,7 @@ class RawCluster;
 class SvtxTrackMap;
 class JetMap;
 class GlobalVertex;
+class GlobalVertexMap;
 class PHHepMCGenEventMap;
 class JetEvalStack;
 class JetRecoEval;
@@ -25,6 +32,15 @@ class PHHepMCGenEvent;
 class CaloTriggerInfo;
 class JetTruthEval;
 class SvtxEvalStack;
+class Jet;
+class EtaPhiGrid;
+class ColumnTree;
+class ColumnCollection;
+class OutputPolicy;
+class EventIndex;
+class ThreadPool;
+class ClusterKinematics;
+class RowBuffer;
 
 /// Definition of this analysis module class
 class AnaTutorial : public SubsysReco
@@ -40,6 +56,9 @@ class AnaTutorial : public SubsysReco
   /// SubsysReco initialize processing method
   int Init(PHCompositeNode *);
 
+  /// SubsysReco run initialization method, builds the evaluation stack
+  int InitRun(PHCompositeNode *);
+
   /// SubsysReco event processing method
   int process_event(PHCompositeNode *);
 
@@ -52,16 +71,66 @@ class AnaTutorial : public SubsysReco
   /// Set the minimum cluster pT to cut on
   void setMinClusPt(float mincluspt) { m_mincluspt = mincluspt; }
 
+  /// Collect the clusters for every GlobalVertex (one row per cluster and
+  /// vertex, m_clusvtxid tells which) instead of only for the first one
+  void setClusterAllVertices(bool allVertices) { m_clusterAllVertices = allVertices; }
+
   /// Set things to analyze
   void analyzeTracks(bool analyzeTracks) { m_analyzeTracks = analyzeTracks; }
   void analyzeClusters(bool analyzeClusters) { m_analyzeClusters = analyzeClusters; }
   void analyzeJets(bool analyzeJets) { m_analyzeJets = analyzeJets; }
   void analyzeTruth(bool analyzeTruth) { m_analyzeTruth = analyzeTruth; }
 
+  /// Set compression, basket size, auto flush and scratch directory of the output
+  void setOutputPolicy(const OutputPolicy &policy);
+
+  /// Write one entry per event with all objects stored in vector branches
+  /// (floats instead of doubles) into a single tree instead of one entry
+  /// per object into the six trees
+  void setColumnarOutput(bool columnar) { m_columnarOutput = columnar; }
+
+  /// Match reconstructed jets one-to-one to truth jets (greedy in dR)
+  /// instead of taking the closest truth jet for every reconstructed jet
+  void setJetMatchOneToOne(bool oneToOne) { m_jetMatchOneToOne = oneToOne; }
+
+  /// Switch the truth association caches of the track evaluator on/off.
+  /// The caches are cleared every event by next_event, turning them off
+  /// bounds the per event memory at the cost of repeated lookups
+  void doTrackEvalCaching(bool doCaching) { m_doTrackEvalCaching = doCaching; }
+
+  /// Extract truth, tracks, jets and clusters concurrently on nThreads
+  /// threads (0 or 1: one after the other). The objects are collected per
+  /// tree and the trees are filled after all extractions are done, so the
+  /// output is the same as without threads. There are four extractions,
+  /// more than 4 threads do not help
+  void setParallelExtraction(unsigned int nThreads) { m_nThreads = nThreads; }
+
+  /// Filters for the HepMC particles written to the hepmctree, by default
+  /// all particles of the GenEvent are written. Final state is status 1,
+  /// the status and pid lists are whitelists (empty: all), the pid has to
+  /// match exactly, add both signs for particle and antiparticle
+  void setHepMCFinalStateOnly(bool finalStateOnly) { m_hepmcFinalStateOnly = finalStateOnly; }
+  void addHepMCStatus(int status);
+  void addHepMCPid(int pid);
+  void setHepMCEtaRange(float mineta, float maxeta)
+  {
+    m_hepmcMinEta = mineta;
+    m_hepmcMaxEta = maxeta;
+  }
+  void setHepMCMinPt(float minpt) { m_hepmcMinPt = minpt; }
+
+  /// Record the number of reco jets and the highest cluster pT above
+  /// threshold (scalars njets, maxcluspt, flags recojet, cluster) in the
+  /// event index on the DST node, see anautils/EventIndex.h
+  void fillEventIndex(bool fill) { m_fillEventIndex = fill; }
+
  private:
   /// String to contain the outfile name containing the trees
   std::string m_outfilename;
 
+  /// I/O settings for the outfile and its trees
+  OutputPolicy *m_outputPolicy;
+
   /// Fun4All Histogram Manager tool
   Fun4AllHistoManager *m_hm;
 
@@ -83,11 +152,120 @@ class AnaTutorial : public SubsysReco
   /// A boolean for collecting hepmc information
   bool m_analyzeTruth;
 
+  /// A boolean for caching the truth associations in the track evaluator
+  bool m_doTrackEvalCaching;
+
+  /// HepMC particle filters
+  bool m_hepmcFinalStateOnly;
+  float m_hepmcMinEta;
+  float m_hepmcMaxEta;
+  float m_hepmcMinPt;
+
+  /// Number of HepMC particles looked at and written
+  long m_hepmcParticlesSeen;
+  long m_hepmcParticlesKept;
+
+  /// Number of threads for the extraction and their pool
+  unsigned int m_nThreads;
+  ThreadPool *m_threadPool;
+
+  /// Evaluation stack for truth track matching, created once per run
+  SvtxEvalStack *m_svtxEvalStack;
+
+  /// A boolean for writing the per event columnar tree
+  bool m_columnarOutput;
+
+  /// Per event tree and its collections for the columnar output
+  ColumnTree *m_eventtree;
+  ColumnCollection *m_clustercolumns;
+  ColumnCollection *m_trackcolumns;
+  ColumnCollection *m_hepmccolumns;
+  ColumnCollection *m_hepmceventcolumns;
+  ColumnCollection *m_truthcolumns;
+  ColumnCollection *m_recojetcolumns;
+  ColumnCollection *m_truthjetcolumns;
+
+  /// A boolean for one-to-one reco-truth jet matching
+  bool m_jetMatchOneToOne;
+
+  /// eta-phi index of the truth jets used for the reco-truth jet matching
+  EtaPhiGrid *m_truthJetGrid;
+
+  /// A boolean for filling the event index
+  bool m_fillEventIndex;
+
+  /// Event index on the DST node and the slots registered by this module
+  EventIndex *m_eventIndex;
+  int m_njetsScalar;
+  int m_maxClusPtScalar;
+  int m_recoJetFlag;
+  int m_clusterFlag;
+
+  /// Highest pT of the clusters above threshold in this event
+  double m_maxcluspt;
+
+  /// A boolean for collecting the clusters for all vertices
+  bool m_clusterAllVertices;
+
+  /// Cluster momenta of an event, computed for all clusters at once
+  ClusterKinematics *m_clusterKinematics;
+
+#if !defined(__CINT__) || defined(__CLING__)
+  /// Handles to the nodes we read, resolved once per run in InitRun
+  NodeHandle<PHHepMCGenEventMap> m_hepmcEventMapNode;
+  NodeHandle<PHG4TruthInfoContainer> m_truthInfoNode;
+  NodeHandle<SvtxTrackMap> m_trackMapNode;
+  NodeHandle<JetMap> m_truthJetNode;
+  NodeHandle<JetMap> m_recoJetNode;
+  NodeHandle<RawClusterContainer> m_clusterNode;
+  NodeHandle<GlobalVertexMap> m_vertexMapNode;
+  NodeHandle<CaloTriggerInfo> m_triggerNode;
+
+  /// The objects of the current event, taken from the handles on the
+  /// main thread before the extraction (possibly in parallel) starts.
+  /// The extraction only reads these pointers, never the handles
+  struct EventNodes
+  {
+    PHHepMCGenEventMap *hepmcEventMap;
+    PHG4TruthInfoContainer *truthInfo;
+    SvtxTrackMap *trackMap;
+    JetMap *truthJets;
+    JetMap *recoJets;
+    RawClusterContainer *clusters;
+    GlobalVertexMap *vertexMap;
+    CaloTriggerInfo *trigger;
+  };
+  EventNodes m_nodes;
+  void getNodes(PHCompositeNode *topNode);
+
+  /// Buffers for the jet matching, reused for every event
+  std::vector<const Jet *> m_matchTruthJets;
+  std::vector<const Jet *> m_matchRecoJets;
+  std::vector<float> m_matchRecoEta;
+  std::vector<float> m_matchRecoPhi;
+  std::vector<int> m_matchIndex;
+  std::vector<float> m_matchDR2;
+
+  /// HepMC status and pid whitelists, sorted
+  std::vector<int> m_hepmcStatus;
+  std::vector<int> m_hepmcPids;
+
+  /// Rows collected by the parallel extraction, one buffer per tree
+  struct StagedTree
+  {
+    TTree *tree;
+    ColumnCollection *columns;
+    RowBuffer *rows;
+  };
+  std::vector<StagedTree> m_stagedTrees;
+#endif
+
   /// TFile to hold the following TTrees and histograms
   TFile *m_outfile;
   TTree *m_clustertree;
   TTree *m_tracktree;
   TTree *m_hepmctree;
+  TTree *m_hepmceventtree;
   TTree *m_truthtree;
   TTree *m_recojettree;
   TTree *m_truthjettree;
@@ -102,20 +280,38 @@ class AnaTutorial : public SubsysReco
   void getHEPMCTruth(PHCompositeNode *topNode);
   void getPHG4Truth(PHCompositeNode *topNode);
 
+  /// Run the getters above on the thread pool and fill the trees
+  void extractParallel(PHCompositeNode *topNode);
+  void initializeStagedTrees();
+
   void initializeVariables();
   void initializeTrees();
+  void initializeColumnTree();
+
+  /// Fill the current object into its flat tree or the column collection
+  void fillObject(TTree *tree, ColumnCollection *columns);
 
   /**
    * Make variables for the relevant trees
    */
 
-  /// HEPMC Tree variables
+  /// Event number in this job, connects the hepmctree particles to
+  /// their hepmceventtree entry
+  int m_eventnumber;
+
+  /// HEPMC event tree variables (one entry per GenEvent)
+  int m_hepmcid;
   int m_partid1;
   int m_partid2;
   double m_x1;
   double m_x2;
   int m_mpi;
   int m_process_id;
+  int m_numparticlesinevent;
+  int m_numkeptparticles;
+
+  /// HEPMC particle tree variables
+  int m_truthstatus;
   double m_truthenergy;
   double m_trutheta;
   double m_truthphi;
@@ -124,7 +320,6 @@ class AnaTutorial : public SubsysReco
   double m_truthpz;
   double m_truthpt;
   double m_truthp;
-  int m_numparticlesinevent;
   int m_truthpid;
 
   /// Track variables
@@ -183,6 +378,8 @@ class AnaTutorial : public SubsysReco
   double m_cluspx;
   double m_cluspy;
   double m_cluspz;
+  int m_clusvtxid;
+  double m_clusvtxz;
   double m_E_4x4;
 };
 
@@ -0,0 +1,177 @@
+#include "CellDecoder.h"
+
+#include <g4detectors/PHG4Cell.h>
+#include <g4detectors/PHG4CellContainer.h>
+#include <g4detectors/PHG4CellDefs.h>
+
+using namespace std;
+
+namespace
+{
+  // the bins of one binning scheme, DecodeAll() is instantiated for each
+  struct SlatBins
+  {
+    static int Phi(const PHG4CellDefs::keytype key) { return PHG4CellDefs::ScintillatorSlatBinning::get_row(key); }
+    static int Eta(const PHG4CellDefs::keytype key) { return PHG4CellDefs::ScintillatorSlatBinning::get_column(key); }
+  };
+
+  struct SizeBins
+  {
+    static int Phi(const PHG4CellDefs::keytype key) { return PHG4CellDefs::SizeBinning::get_phibin(key); }
+    static int Eta(const PHG4CellDefs::keytype key) { return PHG4CellDefs::SizeBinning::get_zbin(key); }
+  };
+
+  struct SpacalBins
+  {
+    static int Phi(const PHG4CellDefs::keytype key) { return PHG4CellDefs::SpacalBinning::get_phibin(key); }
+    static int Eta(const PHG4CellDefs::keytype key) { return PHG4CellDefs::SpacalBinning::get_etabin(key); }
+  };
+
+  // decodes the cells with the given binning, returns false for the
+  // first one with a different binning (i is then its position)
+  template <class Bins>
+  bool DecodeAll(const PHG4CellContainer::ConstRange &range, const int binning, unsigned int &i,
+                 PHG4CellContainer::ConstIterator &iter, int *phibin, int *etabin, double *edep)
+  {
+    for (; iter != range.second; ++iter, ++i)
+    {
+      // the key of the map is the cell id
+      const PHG4CellDefs::keytype key = iter->first;
+      if (PHG4CellDefs::get_binning(key) != binning)
+      {
+        return false;
+      }
+      phibin[i] = Bins::Phi(key);
+      etabin[i] = Bins::Eta(key);
+      edep[i] = iter->second->get_edep();
+    }
+    return true;
+  }
+}  // namespace
+
+CellDecoder::CellDecoder()
+  : m_binning(-1)
+{
+}
+
+unsigned int CellDecoder::Decode(const PHG4CellContainer *cells)
+{
+  m_binning = -1;
+  m_phibin.clear();
+  m_etabin.clear();
+  m_edep.clear();
+  if (!cells || cells->size() == 0)
+  {
+    return 0;
+  }
+  PHG4CellContainer::ConstRange range = cells->getCells();
+  m_phibin.resize(cells->size());
+  m_etabin.resize(cells->size());
+  m_edep.resize(cells->size());
+  m_binning = PHG4CellDefs::get_binning(range.first->first);
+
+  unsigned int i = 0;
+  PHG4CellContainer::ConstIterator iter = range.first;
+  while (iter != range.second)
+  {
+    bool done;
+    switch (m_binning)
+    {
+    case PHG4CellDefs::scintillatorslatbinning:
+      done = DecodeAll<SlatBins>(range, m_binning, i, iter, &m_phibin[0], &m_etabin[0], &m_edep[0]);
+      break;
+    case PHG4CellDefs::sizebinning:
+      done = DecodeAll<SizeBins>(range, m_binning, i, iter, &m_phibin[0], &m_etabin[0], &m_edep[0]);
+      break;
+    case PHG4CellDefs::spacalbinning:
+      done = DecodeAll<SpacalBins>(range, m_binning, i, iter, &m_phibin[0], &m_etabin[0], &m_edep[0]);
+      break;
+    default:
+      done = false;
+      break;
+    }
+    if (done)
+    {
+      break;
+    }
+    // a cell the loop above cannot do, continue with the next one
+    DecodeOne(i, iter->first);
+    m_edep[i] = iter->second->get_edep();
+    ++iter;
+    ++i;
+  }
+  return Size();
+}
+
+void CellDecoder::DecodeOne(const unsigned int i, const unsigned long long cellid)
+{
+  const int binning = PHG4CellDefs::get_binning(cellid);
+  switch (binning)
+  {
+  case PHG4CellDefs::scintillatorslatbinning:
+    m_phibin[i] = SlatBins::Phi(cellid);
+    m_etabin[i] = SlatBins::Eta(cellid);
+    break;
+  case PHG4CellDefs::sizebinning:
+    m_phibin[i] = SizeBins::Phi(cellid);
+    m_etabin[i] = SizeBins::Eta(cellid);
+    break;
+  case PHG4CellDefs::spacalbinning:
+    m_phibin[i] = SpacalBins::Phi(cellid);
+    m_etabin[i] = SpacalBins::Eta(cellid);
+    break;
+  default:
+    m_phibin[i] = -999;
+    m_etabin[i] = -999;
+    m_unknown[binning]++;
+    break;
+  }
+}
+
+void CellDecoder::Aggregate()
+{
+  int maxphibin = -1;
+  int maxetabin = -1;
+  for (unsigned int i = 0; i < Size(); i++)
+  {
+    if (m_phibin[i] > maxphibin)
+    {
+      maxphibin = m_phibin[i];
+    }
+    if (m_etabin[i] > maxetabin)
+    {
+      maxetabin = m_etabin[i];
+    }
+  }
+  const int nphibins = maxphibin + 1;
+  m_slot.assign((maxetabin + 1) * nphibins, -1);
+  // entries are only moved towards the front, in place is fine
+  unsigned int n = 0;
+  for (unsigned int i = 0; i < Size(); i++)
+  {
+    if (m_phibin[i] < 0 || m_etabin[i] < 0)
+    {
+      m_phibin[n] = m_phibin[i];
+      m_etabin[n] = m_etabin[i];
+      m_edep[n] = m_edep[i];
+      n++;
+      continue;
+    }
+    int &slot = m_slot[m_etabin[i] * nphibins + m_phibin[i]];
+    if (slot < 0)
+    {
+      slot = n;
+      m_phibin[n] = m_phibin[i];
+      m_etabin[n] = m_etabin[i];
+      m_edep[n] = m_edep[i];
+      n++;
+    }
+    else
+    {
+      m_edep[slot] += m_edep[i];
+    }
+  }
+  m_phibin.resize(n);
+  m_etabin.resize(n);
+  m_edep.resize(n);
+}
@@ -0,0 +1,63 @@
+#ifndef ANAUTILS_CELLDECODER_H
+#define ANAUTILS_CELLDECODER_H
+
+#include <map>
+#include <vector>
+
+class PHG4CellContainer;
+
+/// \class CellDecoder
+/// Phi bin, eta bin and edep of all cells of a PHG4CellContainer in flat
+/// arrays. All cells of a container use the same binning scheme, it is
+/// taken from the first cell id and the ids are then decoded in one loop
+/// for this scheme, instead of asking every cell in turn whether it has
+/// a scintillator slat, size or spacal binning. The bins are the ones
+/// CaloAna always used: row and column for scintillator slats, phi and z
+/// bin for the size binning, phi and eta bin for the spacal.
+///
+/// A cell with a binning which cannot be decoded gets the bins -999, it
+/// is counted per binning (UnknownCells()) so the warning can be printed
+/// once at the end and not for every cell.
+///
+///   process_event: m_decoder.Decode(cells);
+///                  for (i < m_decoder.Size()) ... m_decoder.PhiBin(i) ...
+///   End:           m_decoder.UnknownCells()
+class CellDecoder
+{
+ public:
+  CellDecoder();
+  virtual ~CellDecoder() {}
+
+  //! decode all cells of the container, returns the number of cells
+  unsigned int Decode(const PHG4CellContainer *cells);
+
+  //! sum the edep of the cells with the same (phibin, etabin), afterwards
+  //! there is one entry per bin in the order the bins first appeared.
+  //! Cells with unknown binning are kept as they are
+  void Aggregate();
+
+  unsigned int Size() const { return m_edep.size(); }
+  int PhiBin(const unsigned int i) const { return m_phibin[i]; }
+  int EtaBin(const unsigned int i) const { return m_etabin[i]; }
+  double Edep(const unsigned int i) const { return m_edep[i]; }
+
+  //! binning of the first cell of the last container, -1 if it was empty
+  int Binning() const { return m_binning; }
+
+  //! number of cells with a binning we cannot decode, by binning
+  const std::map<int, unsigned long> &UnknownCells() const { return m_unknown; }
+
+ private:
+  //! decode a cell whose binning differs from the one of the container
+  void DecodeOne(const unsigned int i, const unsigned long long cellid);
+
+  int m_binning;
+  std::vector<int> m_phibin;
+  std::vector<int> m_etabin;
+  std::vector<double> m_edep;
+  std::map<int, unsigned long> m_unknown;
+  //! Aggregate(): entry of a (etabin, phibin), -1 if not seen yet
+  std::vector<int> m_slot;
+};
+
+#endif  // ANAUTILS_CELLDECODER_H
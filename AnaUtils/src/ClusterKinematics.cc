@@ -0,0 +1,123 @@
+#include "ClusterKinematics.h"
+
+#include <calobase/RawCluster.h>
+#include <calobase/RawClusterContainer.h>
+
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+  // The direction from the vertex to the cluster scaled to ECore, a
+  // cluster sitting on the vertex gets a zero vector (as with setMag).
+  // The arrays do not overlap and there is no branch and no conditional
+  // division, so this vectorizes (with -fno-math-errno for the sqrt, see
+  // Makefile.am)
+  void ComputeMomenta(const unsigned int n, const double *__restrict x, const double *__restrict y,
+                      const double *__restrict z, const double *__restrict ecore,
+                      const double vx, const double vy, const double vz,
+                      double *__restrict px, double *__restrict py, double *__restrict pz,
+                      double *__restrict pt2)
+  {
+    for (unsigned int i = 0; i < n; i++)
+    {
+      const double dx = x[i] - vx;
+      const double dy = y[i] - vy;
+      const double dz = z[i] - vz;
+      const double d2 = dx * dx + dy * dy + dz * dz;
+      const double away = (d2 > 0) ? 1. : 0.;
+      const double scale = ecore[i] * away / sqrt(d2 + 1. - away);
+      px[i] = dx * scale;
+      py[i] = dy * scale;
+      pz[i] = dz * scale;
+      pt2[i] = px[i] * px[i] + py[i] * py[i];
+    }
+  }
+}  // namespace
+
+void ClusterKinematics::Fill(const RawClusterContainer *clusters)
+{
+  m_clusters.clear();
+  m_x.clear();
+  m_y.clear();
+  m_z.clear();
+  m_ecore.clear();
+  m_kept.clear();
+  if (!clusters)
+  {
+    return;
+  }
+  RawClusterContainer::ConstRange begin_end = clusters->getClusters();
+  for (RawClusterContainer::ConstIterator iter = begin_end.first; iter != begin_end.second; ++iter)
+  {
+    const RawCluster *cluster = iter->second;
+    const double r = cluster->get_r();
+    const double phi = cluster->get_phi();
+    m_clusters.push_back(cluster);
+    m_x.push_back(r * cos(phi));
+    m_y.push_back(r * sin(phi));
+    m_z.push_back(cluster->get_z());
+    m_ecore.push_back(cluster->get_ecore());
+  }
+}
+
+unsigned int ClusterKinematics::Compute(const double vx, const double vy, const double vz, const double minpt)
+{
+  const unsigned int n = m_clusters.size();
+  m_px.resize(n);
+  m_py.resize(n);
+  m_pz.resize(n);
+  m_pt2.resize(n);
+  const double *x = m_x.data();
+  const double *y = m_y.data();
+  const double *z = m_z.data();
+  const double *ecore = m_ecore.data();
+  double *px = m_px.data();
+  double *py = m_py.data();
+  double *pz = m_pz.data();
+  double *pt2 = m_pt2.data();
+  ComputeMomenta(n, x, y, z, ecore, vx, vy, vz, px, py, pz, pt2);
+
+  const double minpt2 = (minpt > 0) ? minpt * minpt : 0.;
+  m_kept.clear();
+  m_energy.clear();
+  m_pt.clear();
+  m_eta.clear();
+  m_theta.clear();
+  m_phi.clear();
+  for (unsigned int i = 0; i < n; i++)
+  {
+    if (pt2[i] < minpt2)
+    {
+      continue;
+    }
+    // same conventions as CLHEP::Hep3Vector mag, perp, pseudoRapidity,
+    // getTheta and getPhi
+    const double pt = sqrt(pt2[i]);
+    const double p = sqrt(pt2[i] + pz[i] * pz[i]);
+    double eta = 0;
+    if (p > 0)
+    {
+      if (p == pz[i])
+      {
+        eta = 1e72;
+      }
+      else if (p == -pz[i])
+      {
+        eta = -1e72;
+      }
+      else
+      {
+        eta = 0.5 * log((p + pz[i]) / (p - pz[i]));
+      }
+    }
+    m_kept.push_back(i);
+    m_energy.push_back(p);
+    m_pt.push_back(pt);
+    m_eta.push_back(eta);
+    m_theta.push_back((p > 0) ? atan2(pt, pz[i]) : 0.);
+    m_phi.push_back((px[i] == 0 && py[i] == 0) ? 0. : atan2(py[i], px[i]));
+  }
+  return m_kept.size();
+}
@@ -0,0 +1,73 @@
+#ifndef ANAUTILS_CLUSTERKINEMATICS_H
+#define ANAUTILS_CLUSTERKINEMATICS_H
+
+#include <vector>
+
+class RawCluster;
+class RawClusterContainer;
+
+/// \class ClusterKinematics
+/// Momentum vectors of all clusters of an event for a given vertex, like
+/// RawClusterUtility::GetECoreVec (ECore along the line from the vertex to
+/// the cluster position) but for the whole container at once. Fill()
+/// copies the positions and energies into flat arrays once per event,
+/// Compute() then works on these arrays for as many vertices as needed:
+/// one pass computes px, py, pz and pT^2 of every cluster (plain
+/// arithmetic, no branches, which the compiler can vectorize), the pT cut
+/// is applied on pT^2 and only the clusters which pass get eta, theta and
+/// phi. The kept clusters are accessed by 0 <= i < Size().
+///
+///   kinematics.Fill(clusters);
+///   for every vertex: kinematics.Compute(vtx->get_x(), vtx->get_y(), vtx->get_z(), minpt);
+///                     for (i < kinematics.Size()) ... kinematics.Pt(i) ...
+class ClusterKinematics
+{
+ public:
+  ClusterKinematics() {}
+  virtual ~ClusterKinematics() {}
+
+  //! copy position and ECore of all clusters, the arrays keep their memory
+  void Fill(const RawClusterContainer *clusters);
+
+  //! number of clusters filled
+  unsigned int Clusters() const { return m_clusters.size(); }
+
+  //! momenta for this vertex, returns the number of clusters with pT >= minpt
+  unsigned int Compute(const double vx, const double vy, const double vz, const double minpt);
+
+  //! clusters which passed the pT cut in the last Compute()
+  unsigned int Size() const { return m_kept.size(); }
+  const RawCluster *Cluster(const unsigned int i) const { return m_clusters[m_kept[i]]; }
+  double E(const unsigned int i) const { return m_energy[i]; }
+  double Px(const unsigned int i) const { return m_px[m_kept[i]]; }
+  double Py(const unsigned int i) const { return m_py[m_kept[i]]; }
+  double Pz(const unsigned int i) const { return m_pz[m_kept[i]]; }
+  double Pt(const unsigned int i) const { return m_pt[i]; }
+  double Eta(const unsigned int i) const { return m_eta[i]; }
+  double Theta(const unsigned int i) const { return m_theta[i]; }
+  double Phi(const unsigned int i) const { return m_phi[i]; }
+
+ private:
+  //! input, one entry per cluster
+  std::vector<const RawCluster *> m_clusters;
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  std::vector<double> m_z;
+  std::vector<double> m_ecore;
+
+  //! momentum for the current vertex, one entry per cluster
+  std::vector<double> m_px;
+  std::vector<double> m_py;
+  std::vector<double> m_pz;
+  std::vector<double> m_pt2;
+
+  //! one entry per cluster above the pT cut
+  std::vector<unsigned int> m_kept;
+  std::vector<double> m_energy;
+  std::vector<double> m_pt;
+  std::vector<double> m_eta;
+  std::vector<double> m_theta;
+  std::vector<double> m_phi;
+};
+
+#endif  // ANAUTILS_CLUSTERKINEMATICS_H
@@ -0,0 +1,133 @@
+#include "ColumnTree.h"
+
+#include <TLeaf.h>
+#include <TObjArray.h>
+#include <TTree.h>
+
+#include <iostream>
+
+using namespace std;
+
+ColumnCollection::ColumnCollection(TTree *tree, const string &name)
+  : m_tree(tree)
+  , m_name(name)
+  , m_rows(0)
+{
+  m_tree->Branch(("n" + m_name).c_str(), &m_rows, ("n" + m_name + "/I").c_str());
+}
+
+ColumnCollection::~ColumnCollection()
+{
+  for (vector<vector<float> *>::iterator iter = m_floatColumns.begin(); iter != m_floatColumns.end(); ++iter)
+  {
+    delete *iter;
+  }
+  for (vector<vector<int> *>::iterator iter = m_intColumns.begin(); iter != m_intColumns.end(); ++iter)
+  {
+    delete *iter;
+  }
+}
+
+void ColumnCollection::Add(const string &name, const double *source)
+{
+  vector<float> *column = new vector<float>();
+  m_floatSources.push_back(source);
+  m_floatColumns.push_back(column);
+  m_tree->Branch((m_name + "_" + name).c_str(), column);
+}
+
+void ColumnCollection::Add(const string &name, const int *source)
+{
+  vector<int> *column = new vector<int>();
+  m_intSources.push_back(source);
+  m_intColumns.push_back(column);
+  m_tree->Branch((m_name + "_" + name).c_str(), column);
+}
+
+void ColumnCollection::AddFromTree(TTree *tree)
+{
+  TObjArray *leaves = tree->GetListOfLeaves();
+  for (int i = 0; i < leaves->GetEntriesFast(); i++)
+  {
+    TLeaf *leaf = static_cast<TLeaf *>(leaves->UncheckedAt(i));
+    string name = leaf->GetName();
+    if (name.compare(0, 2, "m_") == 0)
+    {
+      name = name.substr(2);
+    }
+    const string type = leaf->GetTypeName();
+    if (type == "Double_t")
+    {
+      Add(name, static_cast<const double *>(leaf->GetValuePointer()));
+    }
+    else if (type == "Int_t")
+    {
+      Add(name, static_cast<const int *>(leaf->GetValuePointer()));
+    }
+    else
+    {
+      cout << "ColumnCollection::AddFromTree - " << tree->GetName() << ": leaf " << leaf->GetName()
+           << " of type " << type << " not supported, skipping it" << endl;
+    }
+  }
+}
+
+void ColumnCollection::AppendRow()
+{
+  for (unsigned int i = 0; i < m_floatSources.size(); i++)
+  {
+    m_floatColumns[i]->push_back(*m_floatSources[i]);
+  }
+  for (unsigned int i = 0; i < m_intSources.size(); i++)
+  {
+    m_intColumns[i]->push_back(*m_intSources[i]);
+  }
+  ++m_rows;
+}
+
+void ColumnCollection::Clear()
+{
+  for (vector<vector<float> *>::iterator iter = m_floatColumns.begin(); iter != m_floatColumns.end(); ++iter)
+  {
+    (*iter)->clear();
+  }
+  for (vector<vector<int> *>::iterator iter = m_intColumns.begin(); iter != m_intColumns.end(); ++iter)
+  {
+    (*iter)->clear();
+  }
+  m_rows = 0;
+}
+
+ColumnTree::ColumnTree(const string &name, const string &title)
+  : m_tree(new TTree(name.c_str(), title.c_str()))
+  , m_event(0)
+{
+  m_tree->Branch("event", &m_event, "event/I");
+}
+
+ColumnTree::~ColumnTree()
+{
+  // the TTree belongs to the directory (output file) it was created in
+  for (vector<ColumnCollection *>::iterator iter = m_collections.begin(); iter != m_collections.end(); ++iter)
+  {
+    delete *iter;
+  }
+}
+
+ColumnCollection *ColumnTree::AddCollection(const string &name)
+{
+  ColumnCollection *collection = new ColumnCollection(m_tree, name);
+  m_collections.push_back(collection);
+  return collection;
+}
+
+int ColumnTree::Fill()
+{
+  int nbytes = m_tree->Fill();
+  for (vector<ColumnCollection *>::iterator iter = m_collections.begin(); iter != m_collections.end(); ++iter)
+  {
+    (*iter)->Clear();
+  }
+  ++m_event;
+  return nbytes;
+}
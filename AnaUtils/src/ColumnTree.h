@@ -0,0 +1,78 @@
+#ifndef ANAUTILS_COLUMNTREE_H
+#define ANAUTILS_COLUMNTREE_H
+
+#include <string>
+#include <vector>
+
+class ColumnTree;
+class TTree;
+
+/// \class ColumnCollection
+/// Group of columns of a ColumnTree for one kind of object (tracks,
+/// clusters, ...), created by ColumnTree::AddCollection
+class ColumnCollection
+{
+ public:
+  //! bind a column to a variable, double is stored as float
+  void Add(const std::string &name, const double *source);
+  void Add(const std::string &name, const int *source);
+
+  //! bind all /D and /I leaves of a flat tree (one branch per variable), the
+  //! column names are the branch names without a leading m_
+  void AddFromTree(TTree *tree);
+
+  //! copy the current values of the bound variables into the columns
+  void AppendRow();
+
+  //! number of rows in this event
+  int Rows() const { return m_rows; }
+
+ private:
+  friend class ColumnTree;
+  ColumnCollection(TTree *tree, const std::string &name);
+  ~ColumnCollection();
+  void Clear();
+
+  TTree *m_tree;
+  std::string m_name;
+  int m_rows;
+
+  std::vector<const double *> m_floatSources;
+  std::vector<std::vector<float> *> m_floatColumns;
+  std::vector<const int *> m_intSources;
+  std::vector<std::vector<int> *> m_intColumns;
+};
+
+/// \class ColumnTree
+/// Writes one TTree entry per event with all objects of a collection
+/// (tracks, clusters, ...) stored as vector branches, instead of one
+/// TTree::Fill per object. A collection is a group of columns bound to
+/// the analysis module's variables: after the variables have been set
+/// for an object AppendRow() copies them into the columns. Doubles are
+/// stored as floats, ints stay ints. Fill() writes the event and clears
+/// the columns, which keep their memory for the next event.
+///
+/// Every collection gets a n<name> count branch, the columns are named
+/// <name>_<variable>, and an event branch holds the event index.
+class ColumnTree
+{
+ public:
+  //! the tree is created in the current directory, open the output file first
+  ColumnTree(const std::string &name, const std::string &title);
+  virtual ~ColumnTree();
+
+  //! add a collection, the pointer is owned by the ColumnTree
+  ColumnCollection *AddCollection(const std::string &name);
+
+  //! write this event as one entry and clear all collections
+  int Fill();
+
+  TTree *GetTree() const { return m_tree; }
+
+ private:
+  TTree *m_tree;
+  int m_event;
+  std::vector<ColumnCollection *> m_collections;
+};
+
+#endif  // ANAUTILS_COLUMNTREE_H
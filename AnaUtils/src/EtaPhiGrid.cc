@@ -0,0 +1,198 @@
+#include "EtaPhiGrid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+  //! candidate pair for the one-to-one matching
+  struct MatchCandidate
+  {
+    float dr2;
+    unsigned int query;
+    unsigned int slot;
+    int index;
+
+    bool operator<(const MatchCandidate &other) const
+    {
+      if (dr2 != other.dr2) return dr2 < other.dr2;
+      if (query != other.query) return query < other.query;
+      return slot < other.slot;
+    }
+  };
+}  // namespace
+
+EtaPhiGrid::EtaPhiGrid(const float cellsize, const float etamin, const float etamax)
+  : m_cellsize(cellsize)
+  , m_etamin(etamin)
+  , m_etamax(etamax)
+  , m_neta(1)
+  , m_nphi(1)
+  , m_phiwidth(2 * M_PI)
+  , m_nentries(0)
+{
+  SetBinning(cellsize, etamin, etamax);
+}
+
+void EtaPhiGrid::SetBinning(const float cellsize, const float etamin, const float etamax)
+{
+  assert(cellsize > 0);
+  assert(etamax > etamin);
+  m_cellsize = cellsize;
+  m_etamin = etamin;
+  m_etamax = etamax;
+  m_neta = max(1, static_cast<int>(ceil((etamax - etamin) / cellsize)));
+  // phi cells are at least cellsize wide and cover 2pi exactly
+  m_nphi = max(1, static_cast<int>(floor(2 * M_PI / cellsize)));
+  m_phiwidth = 2 * M_PI / m_nphi;
+  m_cells.clear();
+  m_cells.resize(m_neta * m_nphi);
+  m_nentries = 0;
+}
+
+void EtaPhiGrid::Reset()
+{
+  for (vector<vector<Entry> >::iterator iter = m_cells.begin(); iter != m_cells.end(); ++iter)
+  {
+    iter->clear();
+  }
+  m_nentries = 0;
+}
+
+void EtaPhiGrid::Add(const float eta, const float phi, const int index)
+{
+  Entry entry;
+  entry.eta = eta;
+  entry.phi = phi;
+  entry.index = index;
+  entry.slot = m_nentries;
+  m_cells[EtaBin(eta) * m_nphi + PhiBin(phi)].push_back(entry);
+  ++m_nentries;
+}
+
+int EtaPhiGrid::EtaBin(const float eta) const
+{
+  // everything outside the range goes into the edge cells
+  if (!(eta > m_etamin))
+  {
+    return 0;
+  }
+  const int bin = static_cast<int>((eta - m_etamin) / m_cellsize);
+  return min(bin, m_neta - 1);
+}
+
+int EtaPhiGrid::PhiBin(const float phi) const
+{
+  float p = fmod(phi, static_cast<float>(2 * M_PI));
+  if (p < 0)
+  {
+    p += 2 * M_PI;
+  }
+  const int bin = static_cast<int>(p / m_phiwidth);
+  return min(max(bin, 0), m_nphi - 1);
+}
+
+void EtaPhiGrid::SearchWindow(const float eta, const float radius, int &etalow, int &etahigh, int &phioffset) const
+{
+  etalow = EtaBin(eta - radius);
+  etahigh = EtaBin(eta + radius);
+  phioffset = static_cast<int>(ceil(radius / m_phiwidth));
+}
+
+int EtaPhiGrid::FindClosest(const float eta, const float phi, const float radius, float &dr2) const
+{
+  int bestindex = -1;
+  unsigned int bestslot = m_nentries;
+  dr2 = NAN;
+  VisitWindow(eta, phi, radius, [&](const Entry &entry, const float d2) {
+    if (bestslot == m_nentries || d2 < dr2 || (d2 == dr2 && entry.slot < bestslot))
+    {
+      bestindex = entry.index;
+      bestslot = entry.slot;
+      dr2 = d2;
+    }
+  });
+  return bestindex;
+}
+
+int EtaPhiGrid::FindClosestBruteForce(const float eta, const float phi, const float radius, float &dr2) const
+{
+  const float r2 = radius * radius;
+  int bestindex = -1;
+  unsigned int bestslot = m_nentries;
+  dr2 = NAN;
+  for (vector<vector<Entry> >::const_iterator celliter = m_cells.begin(); celliter != m_cells.end(); ++celliter)
+  {
+    for (vector<Entry>::const_iterator iter = celliter->begin(); iter != celliter->end(); ++iter)
+    {
+      const float d2 = DeltaR2(eta, phi, iter->eta, iter->phi);
+      if (!(d2 < r2))
+      {
+        continue;
+      }
+      if (bestslot == m_nentries || d2 < dr2 || (d2 == dr2 && iter->slot < bestslot))
+      {
+        bestindex = iter->index;
+        bestslot = iter->slot;
+        dr2 = d2;
+      }
+    }
+  }
+  return bestindex;
+}
+
+void EtaPhiGrid::Match(const vector<float> &eta, const vector<float> &phi, const float radius,
+                       const MatchMode mode, vector<int> &match, vector<float> &dr2) const
+{
+  assert(eta.size() == phi.size());
+  match.assign(eta.size(), -1);
+  dr2.assign(eta.size(), NAN);
+
+  if (mode == kClosest)
+  {
+    for (unsigned int i = 0; i < eta.size(); i++)
+    {
+      match[i] = FindClosest(eta[i], phi[i], radius, dr2[i]);
+    }
+    return;
+  }
+
+  if (mode != kOneToOneGreedy)
+  {
+    cout << "EtaPhiGrid::Match - unknown match mode " << mode << endl;
+    return;
+  }
+
+  // collect all pairs within the radius and hand them out
+  // starting with the closest one
+  vector<MatchCandidate> candidates;
+  for (unsigned int i = 0; i < eta.size(); i++)
+  {
+    VisitWindow(eta[i], phi[i], radius, [&](const Entry &entry, const float d2) {
+      MatchCandidate candidate;
+      candidate.dr2 = d2;
+      candidate.query = i;
+      candidate.slot = entry.slot;
+      candidate.index = entry.index;
+      candidates.push_back(candidate);
+    });
+  }
+  sort(candidates.begin(), candidates.end());
+
+  vector<bool> queryused(eta.size(), false);
+  vector<bool> entryused(m_nentries, false);
+  for (vector<MatchCandidate>::const_iterator iter = candidates.begin(); iter != candidates.end(); ++iter)
+  {
+    if (queryused[iter->query] || entryused[iter->slot])
+    {
+      continue;
+    }
+    match[iter->query] = iter->index;
+    dr2[iter->query] = iter->dr2;
+    queryused[iter->query] = true;
+    entryused[iter->slot] = true;
+  }
+}
@@ -0,0 +1,141 @@
+#ifndef ANAUTILS_ETAPHIGRID_H
+#define ANAUTILS_ETAPHIGRID_H
+
+#include <cmath>
+#include <vector>
+
+/// \class EtaPhiGrid
+/// Binned index of objects (jets, tracks, ...) in eta-phi space for fast
+/// neighbour searches. phi is periodic, objects outside the eta range end
+/// up in the edge cells, so nothing is ever lost. A search with radius R
+/// only visits the cells overlapping the R window around the query point
+/// and compares squared distances. Choosing the cell size close to the
+/// search radius (e.g. the jet parameter of a JetMap) keeps this at 3x3 cells.
+///
+/// The cells keep their memory when Reset() is called, so filling the grid
+/// every event does not allocate once the largest event has been seen.
+class EtaPhiGrid
+{
+ public:
+  enum MatchMode
+  {
+    //! each query point gets its closest entry, entries can be used more than once
+    kClosest = 0,
+    //! one-to-one matching, pairs are assigned greedily in increasing distance
+    kOneToOneGreedy = 1
+  };
+
+  EtaPhiGrid(const float cellsize = 0.4, const float etamin = -5., const float etamax = 5.);
+  virtual ~EtaPhiGrid() {}
+
+  //! change the binning, this removes all entries
+  void SetBinning(const float cellsize, const float etamin, const float etamax);
+  float CellSize() const { return m_cellsize; }
+
+  //! remove all entries, the cells keep their memory for the next event
+  void Reset();
+
+  //! add an entry, index is what the searches return (e.g. jet id or position in your loop)
+  void Add(const float eta, const float phi, const int index);
+
+  //! number of entries in the grid
+  unsigned int Entries() const { return m_nentries; }
+
+  //! index of the closest entry with dR < radius, -1 if there is none.
+  //! dr2 is set to the squared distance of the returned entry.
+  //! Entries at identical distance are resolved in favour of the one added first
+  int FindClosest(const float eta, const float phi, const float radius, float &dr2) const;
+
+  //! same as FindClosest but looping over all entries, this is the reference to check the grid against
+  int FindClosestBruteForce(const float eta, const float phi, const float radius, float &dr2) const;
+
+  //! call func(index, dr2) for every entry with dR < radius
+  template <class Func>
+  void ForEachWithin(const float eta, const float phi, const float radius, Func func) const
+  {
+    VisitWindow(eta, phi, radius, [&func](const Entry &entry, const float d2) { func(entry.index, d2); });
+  }
+
+  //! match the query points (eta[i], phi[i]) to the entries within radius.
+  //! match[i] is the index of the matched entry or -1, dr2[i] its squared distance
+  void Match(const std::vector<float> &eta, const std::vector<float> &phi, const float radius,
+             const MatchMode mode, std::vector<int> &match, std::vector<float> &dr2) const;
+
+  //! phi1 - phi2 wrapped into [-pi, pi]
+  static float DeltaPhi(const float phi1, const float phi2)
+  {
+    float dphi = std::fmod(phi1 - phi2, static_cast<float>(2 * M_PI));
+    if (dphi > M_PI)
+    {
+      dphi -= 2 * M_PI;
+    }
+    else if (dphi < -M_PI)
+    {
+      dphi += 2 * M_PI;
+    }
+    return dphi;
+  }
+
+  //! squared distance in eta-phi space
+  static float DeltaR2(const float eta1, const float phi1, const float eta2, const float phi2)
+  {
+    const float deta = eta1 - eta2;
+    const float dphi = DeltaPhi(phi1, phi2);
+    return deta * deta + dphi * dphi;
+  }
+
+ private:
+  struct Entry
+  {
+    float eta;
+    float phi;
+    int index;
+    //! position in the order of Add() calls, used to resolve ties
+    unsigned int slot;
+  };
+
+  //! call visit(entry, dr2) for all entries with dR < radius, only the cells overlapping the window are read
+  template <class Visitor>
+  void VisitWindow(const float eta, const float phi, const float radius, Visitor visit) const
+  {
+    const float r2 = radius * radius;
+    int etalow, etahigh, phioffset;
+    SearchWindow(eta, radius, etalow, etahigh, phioffset);
+    // if the window wraps around onto itself all phi cells are read once
+    const bool allphi = (2 * phioffset + 1 >= m_nphi);
+    const int nphi = allphi ? m_nphi : 2 * phioffset + 1;
+    const int phistart = allphi ? 0 : PhiBin(phi) - phioffset + m_nphi;
+    for (int ieta = etalow; ieta <= etahigh; ieta++)
+    {
+      for (int i = 0; i < nphi; i++)
+      {
+        const std::vector<Entry> &cell = m_cells[ieta * m_nphi + (phistart + i) % m_nphi];
+        for (std::vector<Entry>::const_iterator iter = cell.begin(); iter != cell.end(); ++iter)
+        {
+          const float d2 = DeltaR2(eta, phi, iter->eta, iter->phi);
+          if (d2 < r2)
+          {
+            visit(*iter, d2);
+          }
+        }
+      }
+    }
+  }
+
+  int EtaBin(const float eta) const;
+  int PhiBin(const float phi) const;
+  void SearchWindow(const float eta, const float radius, int &etalow, int &etahigh, int &phioffset) const;
+
+  float m_cellsize;
+  float m_etamin;
+  float m_etamax;
+  int m_neta;
+  int m_nphi;
+  float m_phiwidth;
+  unsigned int m_nentries;
+
+  //! cells ordered as etabin * m_nphi + phibin
+  std::vector<std::vector<Entry> > m_cells;
+};
+
+#endif  // ANAUTILS_ETAPHIGRID_H
@@ -0,0 +1,208 @@
+#include "EventIndex.h"
+#include "EventIndexNames.h"
+
+#include <phool/PHCompositeNode.h>
+#include <phool/PHIODataNode.h>
+#include <phool/PHNodeIterator.h>
+#include <phool/getClass.h>
+#include <phool/phool.h>
+
+#include <algorithm>
+#include <cmath>
+
+ClassImp(EventIndex)
+
+using namespace std;
+
+EventIndex::EventIndex()
+  : flags(0)
+  , names(nullptr)
+{
+}
+
+void EventIndex::identify(ostream &os) const
+{
+  os << "EventIndex: flags 0x" << hex << flags << dec;
+  if (!names)
+  {
+    os << ", " << intscalars.size() << " int and " << scalars.size() << " float scalars, no names" << endl;
+    return;
+  }
+  for (unsigned int i = 0; i < names->FlagNames().size(); i++)
+  {
+    os << " " << names->FlagNames()[i] << ":" << Flag(i);
+  }
+  for (unsigned int i = 0; i < names->IntScalarNames().size(); i++)
+  {
+    os << ", " << names->IntScalarNames()[i] << " = " << IntScalar(i);
+  }
+  for (unsigned int i = 0; i < names->ScalarNames().size(); i++)
+  {
+    os << ", " << names->ScalarNames()[i] << " = " << Scalar(i);
+  }
+  os << endl;
+}
+
+void EventIndex::Reset()
+{
+  flags = 0;
+  intscalars.assign(intscalars.size(), -1);
+  scalars.assign(scalars.size(), NAN);
+}
+
+EventIndex *EventIndex::GetOrCreate(PHCompositeNode *topNode, const string &nodename)
+{
+  PHNodeIterator iter(topNode);
+  EventIndex *index = findNode::getClass<EventIndex>(topNode, nodename);
+  if (!index)
+  {
+    PHCompositeNode *dstNode = dynamic_cast<PHCompositeNode *>(iter.findFirst("PHCompositeNode", "DST"));
+    if (!dstNode)
+    {
+      cout << PHWHERE << " DST Node missing, no event index" << endl;
+      return nullptr;
+    }
+    index = new EventIndex();
+    dstNode->addNode(new PHIODataNode<PHObject>(index, nodename.c_str(), "PHObject"));
+  }
+  const string namesnode = nodename + "NAMES";
+  EventIndexNames *indexnames = findNode::getClass<EventIndexNames>(topNode, namesnode);
+  if (!indexnames)
+  {
+    PHCompositeNode *runNode = dynamic_cast<PHCompositeNode *>(iter.findFirst("PHCompositeNode", "RUN"));
+    if (!runNode)
+    {
+      cout << PHWHERE << " RUN Node missing, no event index" << endl;
+      return nullptr;
+    }
+    indexnames = new EventIndexNames();
+    runNode->addNode(new PHIODataNode<PHObject>(indexnames, namesnode.c_str(), "PHObject"));
+  }
+  index->SetNames(indexnames);
+  return index;
+}
+
+void EventIndex::SetNames(EventIndexNames *n)
+{
+  names = n;
+  // an index made here gets a slot for every name registered so far
+  if (names)
+  {
+    intscalars.resize(max(intscalars.size(), names->IntScalarNames().size()), -1);
+    scalars.resize(max(scalars.size(), names->ScalarNames().size()), NAN);
+  }
+}
+
+int EventIndex::RegisterFlag(const string &name)
+{
+  if (!names)
+  {
+    return -1;
+  }
+  const int bit = names->FlagBit(name);
+  if (bit >= 0)
+  {
+    return bit;
+  }
+  if (names->FlagNames().size() >= static_cast<unsigned int>(MAXFLAGS))
+  {
+    cout << PHWHERE << " all " << MAXFLAGS << " flags are taken, cannot register " << name << endl;
+    return -1;
+  }
+  return names->RegisterFlag(name);
+}
+
+int EventIndex::RegisterIntScalar(const string &name)
+{
+  if (!names)
+  {
+    return -1;
+  }
+  const int i = names->RegisterIntScalar(name);
+  if (intscalars.size() <= static_cast<unsigned int>(i))
+  {
+    intscalars.resize(i + 1, -1);
+  }
+  return i;
+}
+
+int EventIndex::RegisterScalar(const string &name)
+{
+  if (!names)
+  {
+    return -1;
+  }
+  const int i = names->RegisterScalar(name);
+  if (scalars.size() <= static_cast<unsigned int>(i))
+  {
+    scalars.resize(i + 1, NAN);
+  }
+  return i;
+}
+
+int EventIndex::FlagBit(const string &name) const
+{
+  return names ? names->FlagBit(name) : -1;
+}
+
+int EventIndex::IntScalarIndex(const string &name) const
+{
+  return names ? names->IntScalarIndex(name) : -1;
+}
+
+int EventIndex::ScalarIndex(const string &name) const
+{
+  return names ? names->ScalarIndex(name) : -1;
+}
+
+void EventIndex::SetFlag(const int bit, const bool on)
+{
+  if (bit < 0 || bit >= MAXFLAGS)
+  {
+    return;
+  }
+  if (on)
+  {
+    flags |= (1U << bit);
+  }
+  else
+  {
+    flags &= ~(1U << bit);
+  }
+}
+
+void EventIndex::SetIntScalar(const int i, const int value)
+{
+  if (i < 0 || i >= static_cast<int>(intscalars.size()))
+  {
+    return;
+  }
+  intscalars[i] = value;
+}
+
+int EventIndex::IntScalar(const int i) const
+{
+  if (i < 0 || i >= static_cast<int>(intscalars.size()))
+  {
+    return -1;
+  }
+  return intscalars[i];
+}
+
+void EventIndex::SetScalar(const int i, const float value)
+{
+  if (i < 0 || i >= static_cast<int>(scalars.size()))
+  {
+    return;
+  }
+  scalars[i] = value;
+}
+
+float EventIndex::Scalar(const int i) const
+{
+  if (i < 0 || i >= static_cast<int>(scalars.size()))
+  {
+    return NAN;
+  }
+  return scalars[i];
+}
@@ -0,0 +1,87 @@
+#ifndef ANAUTILS_EVENTINDEX_H
+#define ANAUTILS_EVENTINDEX_H
+
+#include <phool/PHObject.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+class EventIndexNames;
+class PHCompositeNode;
+
+/// \class EventIndex
+/// One small row per event: up to 32 selection flags, a few named int
+/// scalars (event number, number of jets, ...) and float scalars
+/// (highest cluster pT, ...). The object lives on the DST node, modules
+/// register their flags and scalars in Init and set them in
+/// process_event, Fun4All resets it after every event. An output manager
+/// with the same event selectors as the DST output which writes only
+/// this node gives a companion file with one entry per DST entry:
+///
+///   Fun4AllDstOutputManager *index = new Fun4AllDstOutputManager("INDEX", "dst_index.root");
+///   index->AddEventSelector("MYTREE");
+///   index->AddNode("EVENTINDEX");
+///
+/// A later pass scans the (tiny) index file and reads only the DST
+/// entries which pass, see MyOwnTTree/macro/SkimWithEventIndex.C.
+/// An entry holds only the values, the names are an EventIndexNames
+/// object on the RUN node which the output manager writes once into the
+/// run tree of the file. Files made by jobs which registered the same
+/// names in the same order can be added with hadd.
+class EventIndex : public PHObject
+{
+ public:
+  static const int MAXFLAGS = 32;
+
+  EventIndex();
+  virtual ~EventIndex() {}
+
+  void identify(std::ostream &os = std::cout) const;
+  /// clears the flags, sets the int scalars to -1 and the float scalars
+  /// to NAN
+  void Reset();
+  int isValid() const { return 1; }
+
+  /// the index on the DST node and its names on the RUN node (node name
+  /// nodename + "NAMES"), created if they do not exist yet
+  static EventIndex *GetOrCreate(PHCompositeNode *topNode, const std::string &nodename = "EVENTINDEX");
+
+  /// the names of the flags and scalars, not owned. GetOrCreate() sets
+  /// them, a reader of an index file passes the object from the run tree
+  void SetNames(EventIndexNames *n);
+  const EventIndexNames *Names() const { return names; }
+
+  /// returns the bit (scalar index) for this name, registering the same
+  /// name twice returns the same bit. -1 if all 32 flags are taken or
+  /// there are no names
+  int RegisterFlag(const std::string &name);
+  int RegisterIntScalar(const std::string &name);
+  int RegisterScalar(const std::string &name);
+  /// -1 if the name is not registered
+  int FlagBit(const std::string &name) const;
+  int IntScalarIndex(const std::string &name) const;
+  int ScalarIndex(const std::string &name) const;
+
+  void SetFlag(const int bit, const bool on = true);
+  bool Flag(const int bit) const { return (bit >= 0 && bit < MAXFLAGS) && ((flags >> bit) & 1U); }
+  unsigned int Flags() const { return flags; }
+
+  /// counts and numbers which have to stay exact (a float is exact only
+  /// up to 2^24)
+  void SetIntScalar(const int i, const int value);
+  int IntScalar(const int i) const;
+
+  void SetScalar(const int i, const float value);
+  float Scalar(const int i) const;
+
+ protected:
+  unsigned int flags;
+  std::vector<int> intscalars;
+  std::vector<float> scalars;
+  EventIndexNames *names;  //! on the RUN node
+
+  ClassDef(EventIndex, 2)
+};
+
+#endif  // ANAUTILS_EVENTINDEX_H
@@ -0,0 +1,5 @@
+#ifdef __CINT__
+// with the + root splits flags and scalars into their own branches
+#pragma link C++ class EventIndex+;
+
+#endif /* __CINT__ */
@@ -0,0 +1,79 @@
+#include "EventIndexNames.h"
+
+ClassImp(EventIndexNames)
+
+using namespace std;
+
+namespace
+{
+  int FindName(const vector<string> &names, const string &name)
+  {
+    for (unsigned int i = 0; i < names.size(); i++)
+    {
+      if (names[i] == name)
+      {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  int AddName(vector<string> &names, const string &name)
+  {
+    const int i = FindName(names, name);
+    if (i >= 0)
+    {
+      return i;
+    }
+    names.push_back(name);
+    return names.size() - 1;
+  }
+
+  void PrintNames(ostream &os, const char *label, const vector<string> &names)
+  {
+    os << " " << label << ":";
+    for (unsigned int i = 0; i < names.size(); i++)
+    {
+      os << " " << names[i];
+    }
+  }
+}  // namespace
+
+void EventIndexNames::identify(ostream &os) const
+{
+  os << "EventIndexNames:";
+  PrintNames(os, "flags", flagnames);
+  PrintNames(os, "int scalars", intscalarnames);
+  PrintNames(os, "scalars", scalarnames);
+  os << endl;
+}
+
+int EventIndexNames::RegisterFlag(const string &name)
+{
+  return AddName(flagnames, name);
+}
+
+int EventIndexNames::RegisterIntScalar(const string &name)
+{
+  return AddName(intscalarnames, name);
+}
+
+int EventIndexNames::RegisterScalar(const string &name)
+{
+  return AddName(scalarnames, name);
+}
+
+int EventIndexNames::FlagBit(const string &name) const
+{
+  return FindName(flagnames, name);
+}
+
+int EventIndexNames::IntScalarIndex(const string &name) const
+{
+  return FindName(intscalarnames, name);
+}
+
+int EventIndexNames::ScalarIndex(const string &name) const
+{
+  return FindName(scalarnames, name);
+}
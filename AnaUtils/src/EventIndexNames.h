@@ -0,0 +1,49 @@
+#ifndef ANAUTILS_EVENTINDEXNAMES_H
+#define ANAUTILS_EVENTINDEXNAMES_H
+
+#include <phool/PHObject.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// \class EventIndexNames
+/// The names of the flags and scalars of an EventIndex. They are the
+/// same for every event, so they live on the RUN node and are written
+/// once per file (into the run tree T1), not with every index entry.
+/// EventIndex::GetOrCreate() puts both on the node tree, a reader of an
+/// index file hands the names to the index with EventIndex::SetNames().
+class EventIndexNames : public PHObject
+{
+ public:
+  EventIndexNames() {}
+  virtual ~EventIndexNames() {}
+
+  void identify(std::ostream &os = std::cout) const;
+  /// the names are kept, they describe the whole file
+  void Reset() {}
+  int isValid() const { return 1; }
+
+  /// position of the name, registering the same name twice returns the
+  /// same position
+  int RegisterFlag(const std::string &name);
+  int RegisterIntScalar(const std::string &name);
+  int RegisterScalar(const std::string &name);
+  /// -1 if the name is not registered
+  int FlagBit(const std::string &name) const;
+  int IntScalarIndex(const std::string &name) const;
+  int ScalarIndex(const std::string &name) const;
+
+  const std::vector<std::string> &FlagNames() const { return flagnames; }
+  const std::vector<std::string> &IntScalarNames() const { return intscalarnames; }
+  const std::vector<std::string> &ScalarNames() const { return scalarnames; }
+
+ protected:
+  std::vector<std::string> flagnames;
+  std::vector<std::string> intscalarnames;
+  std::vector<std::string> scalarnames;
+
+  ClassDef(EventIndexNames, 1)
+};
+
+#endif  // ANAUTILS_EVENTINDEXNAMES_H
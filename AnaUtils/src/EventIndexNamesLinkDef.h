@@ -0,0 +1,5 @@
+#ifdef __CINT__
+
+#pragma link C++ class EventIndexNames+;
+
+#endif /* __CINT__ */
@@ -0,0 +1,228 @@
+#include "HistoBuffer.h"
+
+#include <TArrayD.h>
+#include <TArrayF.h>
+#include <TAxis.h>
+#include <TH1.h>
+
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+  //! the contents of TH1F/TH1D are the TArrayF/TArrayD they inherit from,
+  //! added to like their AddBinContent does it
+  template <class T>
+  void AddToContents(T *contents, const vector<int> &bins, const vector<double> &weights)
+  {
+    const unsigned int n = bins.size();
+    for (unsigned int i = 0; i < n; i++)
+    {
+      contents[bins[i]] += T(weights[i]);
+    }
+  }
+}  // namespace
+
+HistoBuffer::HistoBuffer(TH1 *histo, const unsigned int capacity)
+  : m_histo(nullptr)
+  , m_dimension(0)
+  , m_capacity(capacity > 0 ? capacity : 1)
+{
+  m_x.reserve(m_capacity);
+  m_y.reserve(m_capacity);
+  m_w.reserve(m_capacity);
+  SetHisto(histo);
+}
+
+void HistoBuffer::SetHisto(TH1 *histo)
+{
+  Flush();
+  m_histo = histo;
+  m_dimension = 0;
+  if (!m_histo)
+  {
+    return;
+  }
+  // profiles interpret Fill(x, y) differently
+  if (m_histo->GetDimension() > 2 || m_histo->InheritsFrom("TProfile") || m_histo->InheritsFrom("TProfile2D"))
+  {
+    cout << "HistoBuffer::SetHisto - " << m_histo->GetName() << " is not a 1D or 2D histogram, not buffering it" << endl;
+    m_histo = nullptr;
+    return;
+  }
+  m_dimension = m_histo->GetDimension();
+}
+
+void HistoBuffer::Flush()
+{
+  if (m_histo && !m_x.empty())
+  {
+    if (FastPathPossible())
+    {
+      FlushFast();
+    }
+    else if (m_dimension == 1)
+    {
+      m_histo->FillN(m_x.size(), &m_x[0], &m_w[0]);
+    }
+    else
+    {
+      m_histo->FillN(m_x.size(), &m_x[0], &m_y[0], &m_w[0], 1);
+    }
+  }
+  m_x.clear();
+  m_y.clear();
+  m_w.clear();
+}
+
+bool HistoBuffer::FastPathPossible() const
+{
+  // a histogram with its own buffer (TH1::SetBuffer) has to see every value
+  if (m_histo->GetBuffer() || m_histo->CanExtendAllAxes())
+  {
+    return false;
+  }
+  for (int i = 0; i < m_dimension; i++)
+  {
+    const TAxis *axis = (i == 0) ? m_histo->GetXaxis() : m_histo->GetYaxis();
+    // variable bins, labels, or a range which changes what GetStats() returns
+    if (axis->GetXbins()->GetSize() > 0 || axis->GetLabels() || axis->TestBit(TAxis::kAxisRange))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void HistoBuffer::ComputeBins(const vector<double> &values, const int nbins, const double min,
+                              const double max, vector<int> &bins)
+{
+  // same arithmetic as TAxis::FindFixBin so the values land in the same bins,
+  // without branches the compiler can vectorize this loop
+  const unsigned int n = values.size();
+  bins.resize(n);
+  const double width = max - min;
+  for (unsigned int i = 0; i < n; i++)
+  {
+    const double x = values[i];
+    const bool below = x < min;
+    const bool above = !(x < max);
+    const double clamped = (below || above) ? min : x;
+    const int bin = 1 + int(nbins * (clamped - min) / width);
+    bins[i] = below ? 0 : (above ? nbins + 1 : bin);
+  }
+}
+
+void HistoBuffer::FlushFast()
+{
+  const unsigned int n = m_x.size();
+  const TAxis *xaxis = m_histo->GetXaxis();
+  const int nx = xaxis->GetNbins();
+  ComputeBins(m_x, nx, xaxis->GetXmin(), xaxis->GetXmax(), m_xbins);
+  int ny = 0;
+  if (m_dimension == 2)
+  {
+    const TAxis *yaxis = m_histo->GetYaxis();
+    ny = yaxis->GetNbins();
+    ComputeBins(m_y, ny, yaxis->GetXmin(), yaxis->GetXmax(), m_ybins);
+    m_bins.resize(n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+      m_bins[i] = m_ybins[i] * (nx + 2) + m_xbins[i];
+    }
+  }
+  const vector<int> &bins = (m_dimension == 2) ? m_bins : m_xbins;
+
+  // GetStats() recomputes the statistics from the bin contents if the sum
+  // of weights is 0 but there are entries (all earlier values under- or
+  // overflowed), so it has to see the contents without this batch
+  double stats[13] = {0};
+  m_histo->GetStats(stats);
+
+  // TH1::Fill starts the sum of squared weights at the first weight != 1,
+  // all values filled before had weight 1 so Sumw2() gets them right
+  if (m_histo->GetSumw2N() == 0 && !m_histo->TestBit(TH1::kIsNotW))
+  {
+    for (unsigned int i = 0; i < n; i++)
+    {
+      if (m_w[i] != 1.)
+      {
+        m_histo->Sumw2();
+        break;
+      }
+    }
+  }
+
+  // no virtual AddBinContent per value for the usual float and double
+  // histograms, the other types saturate their integer contents
+  TArrayD *dcontents = dynamic_cast<TArrayD *>(m_histo);
+  TArrayF *fcontents = dcontents ? nullptr : dynamic_cast<TArrayF *>(m_histo);
+  if (dcontents)
+  {
+    AddToContents(dcontents->fArray, bins, m_w);
+  }
+  else if (fcontents)
+  {
+    AddToContents(fcontents->fArray, bins, m_w);
+  }
+  else
+  {
+    for (unsigned int i = 0; i < n; i++)
+    {
+      m_histo->AddBinContent(bins[i], m_w[i]);
+    }
+  }
+  if (m_histo->GetSumw2N() > 0)
+  {
+    double *sumw2 = m_histo->GetSumw2()->fArray;
+    for (unsigned int i = 0; i < n; i++)
+    {
+      sumw2[bins[i]] += m_w[i] * m_w[i];
+    }
+  }
+
+  // the statistics are updated like TH1::Fill does it, only values inside
+  // the axis ranges are counted
+  if (m_dimension == 1)
+  {
+    for (unsigned int i = 0; i < n; i++)
+    {
+      const int bin = m_xbins[i];
+      if (bin == 0 || bin > nx)
+      {
+        continue;
+      }
+      const double w = m_w[i];
+      const double x = m_x[i];
+      stats[0] += w;
+      stats[1] += w * w;
+      stats[2] += w * x;
+      stats[3] += w * x * x;
+    }
+  }
+  else
+  {
+    for (unsigned int i = 0; i < n; i++)
+    {
+      const int binx = m_xbins[i];
+      const int biny = m_ybins[i];
+      if (binx == 0 || binx > nx || biny == 0 || biny > ny)
+      {
+        continue;
+      }
+      const double w = m_w[i];
+      const double x = m_x[i];
+      const double y = m_y[i];
+      stats[0] += w;
+      stats[1] += w * w;
+      stats[2] += w * x;
+      stats[3] += w * x * x;
+      stats[4] += w * y;
+      stats[5] += w * y * y;
+      stats[6] += w * x * y;
+    }
+  }
+  m_histo->PutStats(stats);
+  m_histo->SetEntries(m_histo->GetEntries() + n);
+}
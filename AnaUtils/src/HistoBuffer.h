@@ -0,0 +1,89 @@
+#ifndef ANAUTILS_HISTOBUFFER_H
+#define ANAUTILS_HISTOBUFFER_H
+
+#include <vector>
+
+class TH1;
+
+/// \class HistoBuffer
+/// Collects the (x, y, weight) values for a 1D or 2D histogram in
+/// contiguous arrays and fills them in one go when the buffer is full or
+/// Flush() is called, instead of one TH1::Fill (virtual call and bin
+/// search) per value. For fixed, uniform binning the bins are computed
+/// with plain arithmetic over the whole buffer and, for TH1F/TH1D/TH2F/
+/// TH2D, added directly to the bin arrays. The contents, errors and
+/// statistics end up as with TH1::Fill. Everything else (variable bins,
+/// axes which can extend) goes through TH1::FillN.
+///
+/// The histogram is not owned. Flush() before the histogram is written or
+/// used, e.g. in End(). Calling Fill() after the histogram was deleted
+/// is a bug, as it would be with the histogram itself.
+///
+///   HistoBuffer m_hEtaBuffer(m_hEta);
+///   process_event: m_hEtaBuffer.Fill(jet->get_eta());
+///   End:           m_hEtaBuffer.Flush(); m_hEta->Write();
+class HistoBuffer
+{
+ public:
+  //! capacity is the number of values collected before the histogram is filled
+  explicit HistoBuffer(TH1 *histo = nullptr, const unsigned int capacity = 4096);
+  virtual ~HistoBuffer() {}
+
+  //! change the histogram, the values for the old one are filled first
+  void SetHisto(TH1 *histo);
+  TH1 *GetHisto() const { return m_histo; }
+
+  //! like TH1::Fill: (x, weight) for a 1D histogram, (x, y) for a 2D histogram
+  void Fill(const double x, const double b = 1.)
+  {
+    if (m_dimension == 2)
+    {
+      Add(x, b, 1.);
+    }
+    else
+    {
+      Add(x, 0., b);
+    }
+  }
+
+  //! (x, y, weight) for a 2D histogram
+  void Fill(const double x, const double y, const double w) { Add(x, y, w); }
+
+  //! fill the buffered values into the histogram
+  void Flush();
+
+  //! number of buffered values
+  unsigned int Size() const { return m_x.size(); }
+
+ private:
+  void Add(const double x, const double y, const double w)
+  {
+    m_x.push_back(x);
+    m_y.push_back(y);
+    m_w.push_back(w);
+    if (m_x.size() >= m_capacity)
+    {
+      Flush();
+    }
+  }
+
+  //! uniform binning, no extendable axes, no labels
+  bool FastPathPossible() const;
+  void FlushFast();
+  //! bins along one axis, 0 underflow and nbins+1 overflow like TAxis::FindFixBin
+  static void ComputeBins(const std::vector<double> &values, const int nbins, const double min,
+                          const double max, std::vector<int> &bins);
+
+  TH1 *m_histo;
+  int m_dimension;
+  unsigned int m_capacity;
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  std::vector<double> m_w;
+  std::vector<int> m_xbins;
+  std::vector<int> m_ybins;
+  //! global bins of 2D values
+  std::vector<int> m_bins;
+};
+
+#endif  // ANAUTILS_HISTOBUFFER_H
@@ -0,0 +1,98 @@
+#ifndef ANAUTILS_NODEHANDLE_H
+#define ANAUTILS_NODEHANDLE_H
+
+#include <phool/PHCompositeNode.h>
+#include <phool/PHIODataNode.h>
+#include <phool/PHNodeIterator.h>
+#include <phool/PHObject.h>
+#include <phool/getClass.h>
+
+#include <string>
+
+/// \class NodeHandle
+/// Typed handle to an object on the node tree. findNode::getClass walks the
+/// node tree comparing names, which is not something to do for every node
+/// in every event. Resolve the handle once in InitRun, Get() then returns the
+/// cached pointer. If the node holds a PHObject and its object got replaced
+/// (e.g. by an input manager) the new object is picked up by comparing the
+/// data pointer of the node. A handle which could not be resolved is looked
+/// up again on the next Get(), so nodes created later are still found.
+/// Get() updates the handle, call it from one thread and hand the pointer
+/// to the others.
+///
+///   NodeHandle<JetMap> m_truthJets("AntiKt_Truth_r04");
+///   InitRun:       m_truthJets.Resolve(topNode);
+///   process_event: JetMap *truth_jets = m_truthJets.Get(topNode);
+template <class T>
+class NodeHandle
+{
+ public:
+  explicit NodeHandle(const std::string &name = "")
+    : m_name(name)
+    , m_ionode(nullptr)
+    , m_data(nullptr)
+    , m_object(nullptr)
+    , m_resolved(false)
+  {
+  }
+
+  //! change the node name, the handle has to be resolved again
+  void SetName(const std::string &name)
+  {
+    m_name = name;
+    Invalidate();
+  }
+  const std::string &Name() const { return m_name; }
+
+  //! look up the node, call this in InitRun (the node tree may have changed)
+  T *Resolve(PHCompositeNode *topNode)
+  {
+    Invalidate();
+    m_object = findNode::getClass<T>(topNode, m_name);
+    if (!m_object)
+    {
+      return nullptr;
+    }
+    m_resolved = true;
+    PHNodeIterator iter(topNode);
+    m_ionode = dynamic_cast<PHIODataNode<PHObject> *>(iter.findFirst(m_name));
+    if (m_ionode)
+    {
+      m_data = m_ionode->getData();
+    }
+    return m_object;
+  }
+
+  //! cached object, nullptr if the node does not exist
+  T *Get(PHCompositeNode *topNode)
+  {
+    if (!m_resolved)
+    {
+      return Resolve(topNode);
+    }
+    if (m_ionode && m_ionode->getData() != m_data)
+    {
+      m_data = m_ionode->getData();
+      m_object = dynamic_cast<T *>(m_data);
+    }
+    return m_object;
+  }
+
+  //! forget the cached pointers, e.g. at the end of a run
+  void Invalidate()
+  {
+    m_ionode = nullptr;
+    m_data = nullptr;
+    m_object = nullptr;
+    m_resolved = false;
+  }
+
+ private:
+  std::string m_name;
+  PHIODataNode<PHObject> *m_ionode;
+  PHObject *m_data;
+  T *m_object;
+  bool m_resolved;
+};
+
+#endif  // ANAUTILS_NODEHANDLE_H
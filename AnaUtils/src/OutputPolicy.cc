@@ -0,0 +1,107 @@
+#include "OutputPolicy.h"
+
+#include <TFile.h>
+#include <TSystem.h>
+#include <TTree.h>
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+OutputPolicy::OutputPolicy()
+  : m_compressionSettings(-1)
+  , m_basketSize(0)
+  , m_autoFlush(0)
+{
+}
+
+void OutputPolicy::SetCompression(const int algorithm, const int level)
+{
+  if (level < 0 || level > 9)
+  {
+    cout << "OutputPolicy::SetCompression - invalid level " << level << ", keeping the ROOT default" << endl;
+    return;
+  }
+  m_compressionSettings = 100 * algorithm + level;
+}
+
+string OutputPolicy::LocalFileName(const string &filename) const
+{
+  if (m_scratchDir.empty())
+  {
+    return filename;
+  }
+  // the process id keeps jobs sharing a node from overwriting each other
+  ostringstream localname;
+  localname << m_scratchDir << "/" << gSystem->GetPid() << "_" << gSystem->BaseName(filename.c_str());
+  return localname.str();
+}
+
+TFile *OutputPolicy::OpenFile(const string &filename, const string &option) const
+{
+  TFile *file = new TFile(LocalFileName(filename).c_str(), option.c_str());
+  if (m_compressionSettings >= 0)
+  {
+    file->SetCompressionSettings(m_compressionSettings);
+  }
+  return file;
+}
+
+void OutputPolicy::ApplyTo(TTree *tree) const
+{
+  if (m_basketSize > 0)
+  {
+    tree->SetBasketSize("*", m_basketSize);
+  }
+  if (m_autoFlush != 0)
+  {
+    tree->SetAutoFlush(m_autoFlush);
+  }
+}
+
+bool OutputPolicy::Finish(const string &filename) const
+{
+  if (m_scratchDir.empty())
+  {
+    return true;
+  }
+  const string localname = LocalFileName(filename);
+  // rename only works on the same file system, otherwise copy and remove
+  if (gSystem->Rename(localname.c_str(), filename.c_str()) == 0)
+  {
+    return true;
+  }
+  if (!TFile::Cp(localname.c_str(), filename.c_str(), kFALSE))
+  {
+    cout << "OutputPolicy::Finish - could not copy " << localname << " to " << filename
+         << ", leaving it in place" << endl;
+    return false;
+  }
+  gSystem->Unlink(localname.c_str());
+  return true;
+}
+
+void OutputPolicy::Print() const
+{
+  cout << "OutputPolicy: compression ";
+  if (m_compressionSettings < 0)
+    cout << "ROOT default";
+  else
+    cout << "algorithm " << m_compressionSettings / 100 << " level " << m_compressionSettings % 100;
+  cout << ", basket size ";
+  if (m_basketSize > 0)
+    cout << m_basketSize;
+  else
+    cout << "ROOT default";
+  cout << ", auto flush ";
+  if (m_autoFlush != 0)
+    cout << m_autoFlush;
+  else
+    cout << "ROOT default";
+  if (!m_scratchDir.empty())
+  {
+    cout << ", scratch directory " << m_scratchDir;
+  }
+  cout << endl;
+}
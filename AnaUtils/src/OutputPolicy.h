@@ -0,0 +1,78 @@
+#ifndef ANAUTILS_OUTPUTPOLICY_H
+#define ANAUTILS_OUTPUTPOLICY_H
+
+#include <string>
+
+class TFile;
+class TTree;
+
+/// \class OutputPolicy
+/// I/O settings for the output files and trees of the analysis modules.
+/// Configure one in the Fun4All macro and hand it to every module with
+/// SetOutputPolicy(), the modules keep a copy:
+///
+///   OutputPolicy policy;
+///   policy.SetCompression(OutputPolicy::kLZ4, 4);
+///   policy.SetBasketSize(256000);
+///   policy.SetAutoFlush(-30000000);  // flush every ~30 MB
+///   policy.SetScratchDirectory(getenv("TMPDIR"));
+///   caloana->SetOutputPolicy(policy);
+///
+/// With a scratch directory the file is written to the node local disk and
+/// moved to its final location when the module closes it (Finish()).
+/// Everything left unset keeps the ROOT defaults.
+class OutputPolicy
+{
+ public:
+  //! ROOT compression algorithm codes, kZSTD needs ROOT >= 6.20
+  enum Algorithm
+  {
+    kUseGlobal = 0,
+    kZLIB = 1,
+    kLZMA = 2,
+    kOldCompression = 3,
+    kLZ4 = 4,
+    kZSTD = 5
+  };
+
+  OutputPolicy();
+  virtual ~OutputPolicy() {}
+
+  //! compression algorithm and level (0-9), level 0 switches compression off
+  void SetCompression(const int algorithm, const int level);
+  //! basket (buffer) size in bytes for all branches
+  void SetBasketSize(const int bytes) { m_basketSize = bytes; }
+  //! > 0: flush every n entries, < 0: flush every -n bytes written
+  void SetAutoFlush(const long long autoflush) { m_autoFlush = autoflush; }
+  void SetScratchDirectory(const std::string &dir) { m_scratchDir = dir; }
+
+  int GetCompressionSettings() const { return m_compressionSettings; }
+  int GetBasketSize() const { return m_basketSize; }
+  long long GetAutoFlush() const { return m_autoFlush; }
+  const std::string &GetScratchDirectory() const { return m_scratchDir; }
+
+  //! where the file is written while running, in the scratch directory if one is set
+  std::string LocalFileName(const std::string &filename) const;
+
+  //! open LocalFileName(filename) and apply the compression settings
+  TFile *OpenFile(const std::string &filename, const std::string &option = "RECREATE") const;
+
+  //! apply basket size and auto flush, call this after all branches were created
+  void ApplyTo(TTree *tree) const;
+
+  //! move the closed file from the scratch directory to filename, returns false on failure
+  bool Finish(const std::string &filename) const;
+
+  void Print() const;
+
+ private:
+  //! -1: not set, otherwise 100 * algorithm + level
+  int m_compressionSettings;
+  //! 0: not set
+  int m_basketSize;
+  //! 0: not set
+  long long m_autoFlush;
+  std::string m_scratchDir;
+};
+
+#endif  // ANAUTILS_OUTPUTPOLICY_H
@@ -0,0 +1,68 @@
+#include "RowBuffer.h"
+
+#include <TLeaf.h>
+#include <TObjArray.h>
+#include <TTree.h>
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+RowBuffer::RowBuffer(TTree *tree)
+  : m_rows(0)
+{
+  TObjArray *leaves = tree->GetListOfLeaves();
+  for (int i = 0; i < leaves->GetEntriesFast(); i++)
+  {
+    TLeaf *leaf = static_cast<TLeaf *>(leaves->UncheckedAt(i));
+    const string type = leaf->GetTypeName();
+    if (type == "Double_t")
+    {
+      m_doubleSources.push_back(static_cast<double *>(leaf->GetValuePointer()));
+    }
+    else if (type == "Int_t")
+    {
+      m_intSources.push_back(static_cast<int *>(leaf->GetValuePointer()));
+    }
+    else
+    {
+      cout << "RowBuffer - " << tree->GetName() << ": leaf " << leaf->GetName()
+           << " of type " << type << " not supported, skipping it" << endl;
+    }
+  }
+}
+
+void RowBuffer::AppendRow()
+{
+  for (unsigned int i = 0; i < m_doubleSources.size(); i++)
+  {
+    m_doubles.push_back(*m_doubleSources[i]);
+  }
+  for (unsigned int i = 0; i < m_intSources.size(); i++)
+  {
+    m_ints.push_back(*m_intSources[i]);
+  }
+  ++m_rows;
+}
+
+void RowBuffer::Restore(const unsigned int i) const
+{
+  const unsigned int ndoubles = m_doubleSources.size();
+  for (unsigned int j = 0; j < ndoubles; j++)
+  {
+    *m_doubleSources[j] = m_doubles[i * ndoubles + j];
+  }
+  const unsigned int nints = m_intSources.size();
+  for (unsigned int j = 0; j < nints; j++)
+  {
+    *m_intSources[j] = m_ints[i * nints + j];
+  }
+}
+
+void RowBuffer::Clear()
+{
+  m_doubles.clear();
+  m_ints.clear();
+  m_rows = 0;
+}
@@ -0,0 +1,40 @@
+#ifndef ANAUTILS_ROWBUFFER_H
+#define ANAUTILS_ROWBUFFER_H
+
+#include <vector>
+
+class TTree;
+
+/// \class RowBuffer
+/// Copies of the variables a flat tree (one branch per variable, /D and
+/// /I leaves) is bound to, one row per AppendRow(). Used to collect the
+/// objects of an event away from the tree, e.g. in a thread which must not
+/// call TTree::Fill. Restore(i) writes row i back into the variables, after
+/// which the tree (or a ColumnCollection bound to the same variables) can
+/// be filled as usual.
+class RowBuffer
+{
+ public:
+  explicit RowBuffer(TTree *tree);
+  virtual ~RowBuffer() {}
+
+  //! copy the current values of the variables
+  void AppendRow();
+
+  //! write row i back into the variables
+  void Restore(const unsigned int i) const;
+
+  unsigned int Rows() const { return m_rows; }
+
+  //! drop all rows, the memory is kept for the next event
+  void Clear();
+
+ private:
+  std::vector<double *> m_doubleSources;
+  std::vector<int *> m_intSources;
+  std::vector<double> m_doubles;
+  std::vector<int> m_ints;
+  unsigned int m_rows;
+};
+
+#endif  // ANAUTILS_ROWBUFFER_H
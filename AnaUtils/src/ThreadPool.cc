@@ -0,0 +1,93 @@
+#include "ThreadPool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(const unsigned int nthreads)
+  : m_tasks(nullptr)
+  , m_next(0)
+  , m_running(0)
+  , m_batch(0)
+  , m_stop(false)
+{
+  for (unsigned int i = 1; i < nthreads; i++)
+  {
+    m_workers.push_back(thread(&ThreadPool::Work, this));
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wakeup.notify_all();
+  for (vector<thread>::iterator iter = m_workers.begin(); iter != m_workers.end(); ++iter)
+  {
+    iter->join();
+  }
+}
+
+void ThreadPool::Run(const vector<function<void()> > &tasks)
+{
+  unique_lock<mutex> lock(m_mutex);
+  m_tasks = &tasks;
+  m_next = 0;
+  m_exception = nullptr;
+  ++m_batch;
+  m_wakeup.notify_all();
+  RunTasks(lock);
+  // the last tasks may still run in the workers
+  m_done.wait(lock, [this] { return m_running == 0; });
+  m_tasks = nullptr;
+  if (m_exception)
+  {
+    exception_ptr exception = m_exception;
+    m_exception = nullptr;
+    rethrow_exception(exception);
+  }
+}
+
+void ThreadPool::Work()
+{
+  unique_lock<mutex> lock(m_mutex);
+  unsigned long lastbatch = 0;
+  while (true)
+  {
+    m_wakeup.wait(lock, [this, lastbatch] { return m_stop || (m_tasks && m_batch != lastbatch); });
+    if (m_stop)
+    {
+      return;
+    }
+    lastbatch = m_batch;
+    RunTasks(lock);
+  }
+}
+
+void ThreadPool::RunTasks(unique_lock<mutex> &lock)
+{
+  while (m_tasks && m_next < m_tasks->size())
+  {
+    const function<void()> &task = (*m_tasks)[m_next++];
+    ++m_running;
+    lock.unlock();
+    try
+    {
+      task();
+    }
+    catch (...)
+    {
+      lock.lock();
+      if (!m_exception)
+      {
+        m_exception = current_exception();
+      }
+      lock.unlock();
+    }
+    lock.lock();
+    if (--m_running == 0 && m_next >= m_tasks->size())
+    {
+      m_done.notify_all();
+    }
+  }
+}
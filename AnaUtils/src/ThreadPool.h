@@ -0,0 +1,59 @@
+#ifndef ANAUTILS_THREADPOOL_H
+#define ANAUTILS_THREADPOOL_H
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// \class ThreadPool
+/// A few threads which are started once and then run batches of
+/// independent tasks, e.g. the extraction of the collections of one event.
+/// Run() hands the tasks out, works on them in the calling thread as well
+/// and returns when all of them are done, so starting the threads is paid
+/// once per job and not once per event. An exception thrown by a task is
+/// rethrown by Run() after the batch has finished.
+///
+/// The tasks of one batch must not touch the same data, and nothing in
+/// them may write to a TFile (TTree::Fill can flush a basket): collect the
+/// results and fill the trees after Run() returned.
+///
+///   ThreadPool pool(3);
+///   std::vector<std::function<void()> > tasks;
+///   tasks.push_back([this, topNode] { getTracks(topNode); });
+///   pool.Run(tasks);
+class ThreadPool
+{
+ public:
+  //! nthreads is the total number of threads including the caller of Run()
+  explicit ThreadPool(const unsigned int nthreads);
+  virtual ~ThreadPool();
+
+  unsigned int Threads() const { return m_workers.size() + 1; }
+
+  //! run all tasks and wait for them
+  void Run(const std::vector<std::function<void()> > &tasks);
+
+ private:
+  ThreadPool(const ThreadPool &);
+  ThreadPool &operator=(const ThreadPool &);
+
+  void Work();
+  //! run tasks of the current batch until none is left, with m_mutex held
+  void RunTasks(std::unique_lock<std::mutex> &lock);
+
+  std::vector<std::thread> m_workers;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeup;
+  std::condition_variable m_done;
+  const std::vector<std::function<void()> > *m_tasks;
+  unsigned int m_next;
+  unsigned int m_running;
+  unsigned long m_batch;
+  bool m_stop;
+  std::exception_ptr m_exception;
+};
+
+#endif  // ANAUTILS_THREADPOOL_H
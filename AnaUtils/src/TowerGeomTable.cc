@@ -0,0 +1,46 @@
+#include "TowerGeomTable.h"
+
+#include <calobase/RawTowerGeomContainer.h>
+
+using namespace std;
+
+TowerGeomTable::TowerGeomTable()
+  : m_source(nullptr)
+  , m_netabins(0)
+  , m_nphibins(0)
+{
+}
+
+bool TowerGeomTable::Build(const RawTowerGeomContainer *geom)
+{
+  m_source = geom;
+  m_netabins = 0;
+  m_nphibins = 0;
+  m_eta.clear();
+  m_phi.clear();
+  if (!geom)
+  {
+    return false;
+  }
+  m_netabins = geom->get_etabins();
+  m_nphibins = geom->get_phibins();
+  m_eta.resize(m_netabins * m_nphibins);
+  m_phi.resize(m_netabins * m_nphibins);
+
+  // eta and phi of the centers do not depend on each other, look each up once
+  vector<double> phicenter(m_nphibins);
+  for (int iphi = 0; iphi < m_nphibins; iphi++)
+  {
+    phicenter[iphi] = geom->get_phicenter(iphi);
+  }
+  for (int ieta = 0; ieta < m_netabins; ieta++)
+  {
+    const double etacenter = geom->get_etacenter(ieta);
+    for (int iphi = 0; iphi < m_nphibins; iphi++)
+    {
+      m_eta[ieta * m_nphibins + iphi] = etacenter;
+      m_phi[ieta * m_nphibins + iphi] = phicenter[iphi];
+    }
+  }
+  return true;
+}
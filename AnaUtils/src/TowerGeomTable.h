@@ -0,0 +1,72 @@
+#ifndef ANAUTILS_TOWERGEOMTABLE_H
+#define ANAUTILS_TOWERGEOMTABLE_H
+
+#include <calobase/RawTowerDefs.h>
+
+#include <vector>
+
+class RawTowerGeomContainer;
+
+/// \class TowerGeomTable
+/// Tower centers of a calorimeter copied from its RawTowerGeomContainer
+/// into dense arrays indexed by (etabin, phibin). RawTowerGeomContainer
+/// looks the bin centers up in maps behind virtual calls, doing this for
+/// every tower in every event adds up. Build the table once per run and
+/// call Update() with the geometry of the event, it is only rebuilt when
+/// the geometry object changed:
+///
+///   InitRun:       m_table.Build(m_towergeom.Resolve(topNode));
+///   process_event: m_table.Update(m_towergeom.Get(topNode));
+///                  double eta = m_table.Eta(tower->get_bineta(), tower->get_binphi());
+///                  double phi = m_table.Phi(tower->get_id());
+///
+/// The centers are the ones of get_etacenter() and get_phicenter().
+class TowerGeomTable
+{
+ public:
+  TowerGeomTable();
+  virtual ~TowerGeomTable() {}
+
+  //! copy the bin centers of geom, a null pointer empties the table
+  bool Build(const RawTowerGeomContainer *geom);
+
+  //! rebuild only if geom is not the geometry the table was built from
+  bool Update(const RawTowerGeomContainer *geom)
+  {
+    return (geom == m_source && geom) ? true : Build(geom);
+  }
+
+  int EtaBins() const { return m_netabins; }
+  int PhiBins() const { return m_nphibins; }
+  bool Empty() const { return m_eta.empty(); }
+
+  //! true if (etabin, phibin) is inside the table
+  bool Contains(const int etabin, const int phibin) const
+  {
+    return static_cast<unsigned int>(etabin) < static_cast<unsigned int>(m_netabins) &&
+           static_cast<unsigned int>(phibin) < static_cast<unsigned int>(m_nphibins);
+  }
+
+  //! tower center, the bins are not checked (see Contains())
+  double Eta(const int etabin, const int phibin) const { return m_eta[etabin * m_nphibins + phibin]; }
+  double Phi(const int etabin, const int phibin) const { return m_phi[etabin * m_nphibins + phibin]; }
+
+  //! tower center from the tower key (index1 is the eta bin, index2 the phi bin)
+  double Eta(const RawTowerDefs::keytype key) const
+  {
+    return Eta(RawTowerDefs::decode_index1(key), RawTowerDefs::decode_index2(key));
+  }
+  double Phi(const RawTowerDefs::keytype key) const
+  {
+    return Phi(RawTowerDefs::decode_index1(key), RawTowerDefs::decode_index2(key));
+  }
+
+ private:
+  const RawTowerGeomContainer *m_source;
+  int m_netabins;
+  int m_nphibins;
+  std::vector<double> m_eta;
+  std::vector<double> m_phi;
+};
+
+#endif  // ANAUTILS_TOWERGEOMTABLE_H
@@ -0,0 +1,240 @@
+#include "TreePlotter.h"
+
+#include "ThreadPool.h"
+
+#include <RVersion.h>
+#include <TBranch.h>
+#include <TFile.h>
+#include <TH1.h>
+#include <TObjArray.h>
+#include <TROOT.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+  //! the branches in the list and all their sub branches
+  void CollectBranches(TObjArray *list, vector<TBranch *> &branches)
+  {
+    for (int i = 0; i < list->GetEntriesFast(); i++)
+    {
+      TBranch *branch = static_cast<TBranch *>(list->UncheckedAt(i));
+      branches.push_back(branch);
+      CollectBranches(branch->GetListOfBranches(), branches);
+    }
+  }
+}  // namespace
+
+unsigned int TreePlotter::Branch(const string &name)
+{
+  for (unsigned int i = 0; i < m_branches.size(); i++)
+  {
+    if (m_branches[i] == name)
+    {
+      return i;
+    }
+  }
+  m_branches.push_back(name);
+  return m_branches.size() - 1;
+}
+
+void TreePlotter::AddPlot(TH1 *histo, const FillFunction &fill)
+{
+  m_histos.push_back(histo);
+  m_fills.push_back(fill);
+}
+
+Long64_t TreePlotter::Run(TTree *tree, const Long64_t first, const Long64_t last)
+{
+  if (!tree || !CheckBranches(tree))
+  {
+    return -1;
+  }
+  const Long64_t end = (last < 0 || last > tree->GetEntries()) ? tree->GetEntries() : last;
+  RangeList ranges(1, make_pair(first, end));
+  atomic<unsigned int> next(0);
+  return Process(tree, ranges, next, m_histos);
+}
+
+Long64_t TreePlotter::RunParallel(const string &filename, const string &treename, const unsigned int nthreads)
+{
+  // the ranges follow the clusters of the tree, the last cluster ends at
+  // the last entry
+  RangeList ranges;
+  {
+    TFile *f = TFile::Open(filename.c_str());
+    TTree *tree = f ? dynamic_cast<TTree *>(f->Get(treename.c_str())) : nullptr;
+    if (!tree || !CheckBranches(tree))
+    {
+      cout << "TreePlotter::RunParallel - no tree " << treename << " with our branches in " << filename << endl;
+      delete f;
+      return -1;
+    }
+    const Long64_t nentries = tree->GetEntries();
+    TTree::TClusterIterator clusters = tree->GetClusterIterator(0);
+    for (Long64_t start = clusters(); start < nentries; start = clusters())
+    {
+      ranges.push_back(make_pair(start, min(clusters.GetNextEntry(), nentries)));
+    }
+    // with too few clusters the threads would wait for the slowest one, the
+    // entries are then cut into equal pieces and baskets at the borders are
+    // read by two threads
+    if (ranges.size() < 2 * nthreads)
+    {
+      ranges.clear();
+      const Long64_t step = max<Long64_t>(1, (nentries + 4 * nthreads - 1) / (4 * nthreads));
+      for (Long64_t start = 0; start < nentries; start += step)
+      {
+        ranges.push_back(make_pair(start, min(start + step, nentries)));
+      }
+    }
+    delete f;
+  }
+  m_nranges = ranges.size();
+
+  unsigned int nworkers = max(1u, nthreads);
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 0, 0)
+  ROOT::EnableThreadSafety();
+#else
+  nworkers = 1;
+#endif
+  // the copies are made here, TH1::Clone registers histograms in gDirectory
+  vector<vector<TH1 *> > copies(nworkers);
+  const bool adddirectory = TH1::AddDirectoryStatus();
+  TH1::AddDirectory(false);
+  for (unsigned int i = 0; i < nworkers; i++)
+  {
+    for (vector<TH1 *>::const_iterator iter = m_histos.begin(); iter != m_histos.end(); ++iter)
+    {
+      TH1 *copy = static_cast<TH1 *>((*iter)->Clone());
+      copy->Reset();
+      copies[i].push_back(copy);
+    }
+  }
+  TH1::AddDirectory(adddirectory);
+
+  atomic<unsigned int> next(0);
+  vector<Long64_t> nread(nworkers, 0);
+  vector<function<void()> > tasks;
+  for (unsigned int i = 0; i < nworkers; i++)
+  {
+    tasks.push_back([this, i, &filename, &treename, &ranges, &next, &copies, &nread] {
+      // every thread reads through its own file and tree
+      TFile *f = TFile::Open(filename.c_str());
+      TTree *tree = f ? dynamic_cast<TTree *>(f->Get(treename.c_str())) : nullptr;
+      nread[i] = tree ? Process(tree, ranges, next, copies[i]) : -1;
+      delete f;
+    });
+  }
+  ThreadPool pool(nworkers);
+  pool.Run(tasks);
+
+  Long64_t total = 0;
+  for (unsigned int i = 0; i < nworkers; i++)
+  {
+    total = (total < 0 || nread[i] < 0) ? -1 : total + nread[i];
+  }
+  if (total < 0)
+  {
+    cout << "TreePlotter::RunParallel - a thread could not read " << treename << " from " << filename
+         << ", the histograms are not filled" << endl;
+  }
+  for (unsigned int i = 0; i < nworkers; i++)
+  {
+    for (unsigned int j = 0; j < m_histos.size(); j++)
+    {
+      if (total >= 0)
+      {
+        m_histos[j]->Add(copies[i][j]);
+      }
+      delete copies[i][j];
+    }
+  }
+  return total;
+}
+
+bool TreePlotter::CheckBranches(TTree *tree) const
+{
+  for (vector<string>::const_iterator iter = m_branches.begin(); iter != m_branches.end(); ++iter)
+  {
+    if (!tree->GetBranch(iter->c_str()))
+    {
+      cout << "TreePlotter - " << tree->GetName() << " has no branch " << *iter << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+Long64_t TreePlotter::Process(TTree *tree, const RangeList &ranges, atomic<unsigned int> &next,
+                              const vector<TH1 *> &histos) const
+{
+  // only our branches (and their split sub branches) are read, the status
+  // of every branch is put back at the end
+  vector<TBranch *> branches;
+  CollectBranches(tree->GetListOfBranches(), branches);
+  vector<bool> disabled(branches.size());
+  for (unsigned int i = 0; i < branches.size(); i++)
+  {
+    disabled[i] = branches[i]->TestBit(kDoNotProcess);
+  }
+  tree->SetBranchStatus("*", 0);
+
+  // a branch which has an address already is read through it (a pointer to
+  // its TClonesArray pointer), the others get one of ours
+  vector<TClonesArray *> arrays(m_branches.size(), nullptr);
+  vector<bool> ouraddress(m_branches.size(), false);
+  Event event;
+  for (unsigned int i = 0; i < m_branches.size(); i++)
+  {
+    tree->SetBranchStatus((m_branches[i] + "*").c_str(), 1);
+    TBranch *branch = tree->GetBranch(m_branches[i].c_str());
+    if (branch->GetAddress())
+    {
+      event.m_arrays.push_back(reinterpret_cast<TClonesArray **>(branch->GetAddress()));
+    }
+    else
+    {
+      tree->SetBranchAddress(m_branches[i].c_str(), &arrays[i]);
+      event.m_arrays.push_back(&arrays[i]);
+      ouraddress[i] = true;
+    }
+  }
+
+  Long64_t nread = 0;
+  for (unsigned int range = next++; range < ranges.size(); range = next++)
+  {
+    for (Long64_t entry = ranges[range].first; entry < ranges[range].second; entry++)
+    {
+      tree->GetEntry(entry);
+      event.m_entry = entry;
+      for (unsigned int i = 0; i < m_fills.size(); i++)
+      {
+        m_fills[i](event, histos[i]);
+      }
+    }
+    if (ranges[range].second > ranges[range].first)
+    {
+      nread += ranges[range].second - ranges[range].first;
+    }
+  }
+
+  // leave the tree as we found it, the arrays were created by ROOT for us
+  for (unsigned int i = 0; i < m_branches.size(); i++)
+  {
+    if (ouraddress[i])
+    {
+      tree->GetBranch(m_branches[i].c_str())->ResetAddress();
+    }
+    delete arrays[i];
+  }
+  for (unsigned int i = 0; i < branches.size(); i++)
+  {
+    branches[i]->SetBit(kDoNotProcess, disabled[i]);
+  }
+  return nread;
+}
@@ -0,0 +1,110 @@
+#ifndef ANAUTILS_TREEPLOTTER_H
+#define ANAUTILS_TREEPLOTTER_H
+
+#include <TClonesArray.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TH1;
+class TTree;
+
+/// \class TreePlotter
+/// Fills many histograms in one pass over a tree whose branches hold
+/// TClonesArrays of objects, like the output of PHG4DSTReader (PHG4Hit,
+/// RawTower, PHG4Particle, ...). Every plot is a histogram and a compiled
+/// function which gets the arrays of the event, instead of a T->Draw
+/// expression which is parsed, jitted and reads its branches again for
+/// every plot. Only the branches asked for with Branch() are read:
+///
+///   TreePlotter plotter;
+///   const unsigned int hits = plotter.Branch("G4HIT_CEMC");
+///   plotter.AddPlot(hedep, [hits](const TreePlotter::Event &event, TH1 *h) {
+///     for (int i = 0; i < event.Size(hits); i++)
+///       h->Fill(event.Get<PHG4Hit>(hits, i)->get_edep());
+///   });
+///   plotter.Run(T);
+///
+/// The histograms are not owned. The class dictionaries of the objects
+/// (libg4dst) have to be loaded.
+///
+/// RunParallel() reads a tree from a file with several threads. The tree
+/// is split into entry ranges along its clusters (the entries whose
+/// baskets are flushed together), so no basket is read by two threads.
+/// Every thread opens the file itself, pulls ranges until none is left
+/// and fills its own copies of the histograms, which are added to the
+/// histograms at the end. The fill functions are called from several
+/// threads at the same time, they may only touch the histogram they get.
+class TreePlotter
+{
+ public:
+  /// the arrays of the current entry, by the index Branch() returned
+  class Event
+  {
+   public:
+    Long64_t Entry() const { return m_entry; }
+    const TClonesArray *Array(const unsigned int branch) const { return *m_arrays[branch]; }
+    int Size(const unsigned int branch) const { return Array(branch) ? Array(branch)->GetEntriesFast() : 0; }
+    //! object i of the array, not checked
+    template <class T>
+    const T *Get(const unsigned int branch, const int i) const
+    {
+      return static_cast<const T *>(Array(branch)->UncheckedAt(i));
+    }
+
+   private:
+    friend class TreePlotter;
+    Long64_t m_entry;
+    std::vector<TClonesArray **> m_arrays;
+  };
+
+  typedef std::function<void(const Event &, TH1 *)> FillFunction;
+
+  TreePlotter()
+    : m_nranges(0)
+  {
+  }
+  virtual ~TreePlotter() {}
+
+  //! index of the branch with this name, it is read in Run()
+  unsigned int Branch(const std::string &name);
+
+  //! fill is called with the histogram once per entry
+  void AddPlot(TH1 *histo, const FillFunction &fill);
+
+  unsigned int Plots() const { return m_histos.size(); }
+  TH1 *Histo(const unsigned int i) const { return m_histos[i]; }
+
+  //! fill all plots from the entries first <= entry < last (-1: to the end),
+  //! returns the number of entries read or -1 if a branch does not exist.
+  //! Afterwards every branch has its status from before again. A branch
+  //! with an address (a TClonesArray **) is read through it and keeps it
+  Long64_t Run(TTree *tree, const Long64_t first = 0, const Long64_t last = -1);
+
+  //! fill all plots from the tree treename in filename with nthreads
+  //! threads, returns the number of entries read or -1 on failure
+  Long64_t RunParallel(const std::string &filename, const std::string &treename, const unsigned int nthreads);
+
+  //! number of entry ranges the last RunParallel() used
+  unsigned int Ranges() const { return m_nranges; }
+
+ private:
+  typedef std::vector<std::pair<Long64_t, Long64_t> > RangeList;
+
+  //! false (and a message) if the tree lacks one of our branches
+  bool CheckBranches(TTree *tree) const;
+
+  //! fill histos from the ranges handed out by next until none is left
+  Long64_t Process(TTree *tree, const RangeList &ranges, std::atomic<unsigned int> &next,
+                   const std::vector<TH1 *> &histos) const;
+
+  unsigned int m_nranges;
+  std::vector<std::string> m_branches;
+  std::vector<TH1 *> m_histos;
+  std::vector<FillFunction> m_fills;
+};
+
+#endif  // ANAUTILS_TREEPLOTTER_H
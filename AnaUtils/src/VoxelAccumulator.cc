@@ -0,0 +1,61 @@
+#include "VoxelAccumulator.h"
+
+#include <cmath>
+
+using namespace std;
+
+VoxelAccumulator::VoxelAccumulator()
+  : m_voxelsize(0)
+  , m_perlayer(false)
+{
+}
+
+void VoxelAccumulator::Clear()
+{
+  // clear() keeps the buckets of the map and the capacity of the vectors
+  m_index.clear();
+  m_sumx.clear();
+  m_sumy.clear();
+  m_sumz.clear();
+  m_edep.clear();
+  m_deposits.clear();
+  m_layer.clear();
+}
+
+void VoxelAccumulator::Add(const int layer, const double x, const double y, const double z, const double edep)
+{
+  if (!(edep > 0))
+  {
+    return;
+  }
+  Key key;
+  key.layer = m_perlayer ? layer : -1;
+  if (m_voxelsize > 0)
+  {
+    key.ix = static_cast<int>(floor(x / m_voxelsize));
+    key.iy = static_cast<int>(floor(y / m_voxelsize));
+    key.iz = static_cast<int>(floor(z / m_voxelsize));
+  }
+  else
+  {
+    key.ix = 0;
+    key.iy = 0;
+    key.iz = 0;
+  }
+  pair<unordered_map<Key, unsigned int, KeyHash>::iterator, bool> inserted = m_index.insert(make_pair(key, Size()));
+  if (inserted.second)
+  {
+    m_sumx.push_back(0);
+    m_sumy.push_back(0);
+    m_sumz.push_back(0);
+    m_edep.push_back(0);
+    m_deposits.push_back(0);
+    m_layer.push_back(key.layer);
+  }
+  const unsigned int i = inserted.first->second;
+  m_sumx[i] += edep * x;
+  m_sumy[i] += edep * y;
+  m_sumz[i] += edep * z;
+  m_edep[i] += edep;
+  m_deposits[i]++;
+}
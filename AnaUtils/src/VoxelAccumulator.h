@@ -0,0 +1,86 @@
+#ifndef ANAUTILS_VOXELACCUMULATOR_H
+#define ANAUTILS_VOXELACCUMULATOR_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/// \class VoxelAccumulator
+/// Sums energy deposits per voxel of a regular grid, per layer or per
+/// voxel inside a layer. The voxels are found through a hash map keyed by
+/// (layer, voxel indices), so only the voxels which got energy exist and
+/// the size of the detector does not matter. Every voxel keeps the summed
+/// energy, the number of deposits and the energy weighted mean position.
+/// Deposits without energy carry no weight and are ignored.
+/// Clear() keeps the memory for the next event:
+///
+///   Init:          m_voxels.SetVoxelSize(2.); m_voxels.SetPerLayer(true);
+///   process_event: m_voxels.Clear();
+///                  for every hit: m_voxels.Add(hit->get_layer(), x, y, z, hit->get_edep());
+///                  for (i < m_voxels.Size()) ... m_voxels.Edep(i) ...
+class VoxelAccumulator
+{
+ public:
+  VoxelAccumulator();
+  virtual ~VoxelAccumulator() {}
+
+  //! edge length of the cubic voxels, <= 0 for no spatial binning
+  void SetVoxelSize(const double size) { m_voxelsize = size; }
+  double GetVoxelSize() const { return m_voxelsize; }
+
+  //! separate sums for every layer given to Add()
+  void SetPerLayer(const bool b) { m_perlayer = b; }
+  bool GetPerLayer() const { return m_perlayer; }
+
+  //! true if deposits are combined at all
+  bool Active() const { return m_voxelsize > 0 || m_perlayer; }
+
+  void Clear();
+
+  void Add(const int layer, const double x, const double y, const double z, const double edep);
+
+  //! number of voxels with energy, in the order they were first hit
+  unsigned int Size() const { return m_edep.size(); }
+  double X(const unsigned int i) const { return m_sumx[i] / m_edep[i]; }
+  double Y(const unsigned int i) const { return m_sumy[i] / m_edep[i]; }
+  double Z(const unsigned int i) const { return m_sumz[i] / m_edep[i]; }
+  double Edep(const unsigned int i) const { return m_edep[i]; }
+  int Deposits(const unsigned int i) const { return m_deposits[i]; }
+  //! layer of the voxel, -1 without SetPerLayer
+  int Layer(const unsigned int i) const { return m_layer[i]; }
+
+ private:
+  struct Key
+  {
+    int layer;
+    int ix;
+    int iy;
+    int iz;
+    bool operator==(const Key &other) const
+    {
+      return layer == other.layer && ix == other.ix && iy == other.iy && iz == other.iz;
+    }
+  };
+  //! the usual spatial hash, large primes xor-ed
+  struct KeyHash
+  {
+    std::size_t operator()(const Key &key) const
+    {
+      return (static_cast<std::size_t>(key.ix) * 73856093u) ^ (static_cast<std::size_t>(key.iy) * 19349663u) ^
+             (static_cast<std::size_t>(key.iz) * 83492791u) ^ (static_cast<std::size_t>(key.layer) * 2654435761u);
+    }
+  };
+
+  double m_voxelsize;
+  bool m_perlayer;
+  std::unordered_map<Key, unsigned int, KeyHash> m_index;
+  //! one entry per voxel, positions weighted with the energy
+  std::vector<double> m_sumx;
+  std::vector<double> m_sumy;
+  std::vector<double> m_sumz;
+  std::vector<double> m_edep;
+  std::vector<int> m_deposits;
+  std::vector<int> m_layer;
+};
+
+#endif  // ANAUTILS_VOXELACCUMULATOR_H
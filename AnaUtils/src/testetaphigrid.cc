@@ -0,0 +1,254 @@
+// Compares the searches of EtaPhiGrid (FindClosest, ForEachWithin, Match in
+// both modes) with brute force loops over the same points on random events:
+// cell sizes from much smaller to larger than the radius, points and
+// queries outside the eta range of the grid, around the phi seam and
+// outside [-pi, pi], identical positions (ties), radii which cover all of
+// phi. Returns 1 on the first mismatch.
+//   make check
+//   ./testetaphigrid [events] [seed]
+
+#include "EtaPhiGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+  struct Point
+  {
+    float eta;
+    float phi;
+    int index;
+  };
+
+  //! closest point with dR < radius, ties go to the one added first
+  int closest(const vector<Point> &points, const float eta, const float phi, const float radius, float &dr2)
+  {
+    int best = -1;
+    dr2 = NAN;
+    for (unsigned int i = 0; i < points.size(); i++)
+    {
+      const float d2 = EtaPhiGrid::DeltaR2(eta, phi, points[i].eta, points[i].phi);
+      if (d2 < radius * radius && (best < 0 || d2 < dr2))
+      {
+        best = i;
+        dr2 = d2;
+      }
+    }
+    return best < 0 ? -1 : points[best].index;
+  }
+
+  //! greedy one-to-one matching, pairs in increasing distance, then query, then point
+  void greedy(const vector<Point> &points, const vector<float> &eta, const vector<float> &phi, const float radius,
+              vector<int> &match, vector<float> &dr2)
+  {
+    vector<pair<float, pair<unsigned int, unsigned int> > > pairs;
+    for (unsigned int q = 0; q < eta.size(); q++)
+    {
+      for (unsigned int i = 0; i < points.size(); i++)
+      {
+        const float d2 = EtaPhiGrid::DeltaR2(eta[q], phi[q], points[i].eta, points[i].phi);
+        if (d2 < radius * radius)
+        {
+          pairs.push_back(make_pair(d2, make_pair(q, i)));
+        }
+      }
+    }
+    sort(pairs.begin(), pairs.end());
+    match.assign(eta.size(), -1);
+    dr2.assign(eta.size(), NAN);
+    vector<bool> queryused(eta.size(), false);
+    vector<bool> pointused(points.size(), false);
+    for (unsigned int j = 0; j < pairs.size(); j++)
+    {
+      const unsigned int q = pairs[j].second.first;
+      const unsigned int i = pairs[j].second.second;
+      if (queryused[q] || pointused[i])
+      {
+        continue;
+      }
+      match[q] = points[i].index;
+      dr2[q] = pairs[j].first;
+      queryused[q] = true;
+      pointused[i] = true;
+    }
+  }
+
+  //! same index and, if matched, the same squared distance
+  bool same(const int index1, const float dr21, const int index2, const float dr22)
+  {
+    return index1 == index2 && (index1 < 0 || dr21 == dr22);
+  }
+
+  //! eta mostly inside the grid, some beyond the edges
+  float randometa(mt19937 &rnd)
+  {
+    uniform_real_distribution<float> inside(-5, 5);
+    uniform_real_distribution<float> outside(-8, 8);
+    return (rnd() % 5) ? inside(rnd) : outside(rnd);
+  }
+
+  //! phi in [-pi, pi], in [0, 2pi], close to the seam or a few turns away
+  float randomphi(mt19937 &rnd)
+  {
+    uniform_real_distribution<float> turn(-M_PI, M_PI);
+    uniform_real_distribution<float> seam(-0.05, 0.05);
+    switch (rnd() % 4)
+    {
+    case 0:
+      return turn(rnd);
+    case 1:
+      return turn(rnd) + M_PI;
+    case 2:
+      return (rnd() % 2 ? M_PI : -M_PI) + seam(rnd);
+    default:
+      return turn(rnd) + 2 * M_PI * (static_cast<int>(rnd() % 5) - 2);
+    }
+  }
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+  const int nevents = (argc > 1) ? atoi(argv[1]) : 20000;
+  const unsigned int seed = (argc > 2) ? atoi(argv[2]) : 4711;
+  mt19937 rnd(seed);
+  uniform_real_distribution<float> cellsizes(0.05, 1.5);
+  uniform_real_distribution<float> radii(0.01, 1.);
+
+  EtaPhiGrid grid;
+  vector<Point> points;
+  vector<float> queryeta;
+  vector<float> queryphi;
+  vector<int> match;
+  vector<float> matchdr2;
+  vector<int> refmatch;
+  vector<float> refdr2;
+  long nchecks = 0;
+  for (int ievent = 0; ievent < nevents; ievent++)
+  {
+    const float cellsize = cellsizes(rnd);
+    // mostly around the cell size, sometimes far larger, up to all of phi
+    const float radius = (rnd() % 10) ? cellsize * 2 * radii(rnd) : 4 * radii(rnd);
+    if (ievent % 2)
+    {
+      grid.SetBinning(cellsize, -5., 5.);
+    }
+    else
+    {
+      grid.Reset();
+    }
+    points.clear();
+    const unsigned int npoints = rnd() % 40;
+    for (unsigned int i = 0; i < npoints; i++)
+    {
+      Point point;
+      // a copy of an earlier point gives ties
+      if (i > 0 && rnd() % 10 == 0)
+      {
+        point = points[rnd() % i];
+      }
+      else
+      {
+        point.eta = randometa(rnd);
+        point.phi = randomphi(rnd);
+      }
+      point.index = 1000 + 3 * i;
+      points.push_back(point);
+      grid.Add(point.eta, point.phi, point.index);
+    }
+
+    queryeta.clear();
+    queryphi.clear();
+    const unsigned int nqueries = rnd() % 40;
+    for (unsigned int q = 0; q < nqueries; q++)
+    {
+      if (npoints > 0 && rnd() % 10 == 0)
+      {
+        const Point &point = points[rnd() % npoints];
+        queryeta.push_back(point.eta);
+        queryphi.push_back(point.phi);
+      }
+      else
+      {
+        queryeta.push_back(randometa(rnd));
+        queryphi.push_back(randomphi(rnd));
+      }
+    }
+
+    for (unsigned int q = 0; q < nqueries; q++)
+    {
+      const float eta = queryeta[q];
+      const float phi = queryphi[q];
+      float refd2;
+      const int ref = closest(points, eta, phi, radius, refd2);
+      float d2;
+      const int found = grid.FindClosest(eta, phi, radius, d2);
+      float bfd2;
+      const int bf = grid.FindClosestBruteForce(eta, phi, radius, bfd2);
+      if (!same(ref, refd2, found, d2) || !same(ref, refd2, bf, bfd2))
+      {
+        cout << "event " << ievent << ": FindClosest(" << eta << ", " << phi << ", " << radius << ") cell size "
+             << cellsize << " returned " << found << " (dr2 " << d2 << "), brute force " << bf << " (dr2 "
+             << bfd2 << "), expected " << ref << " (dr2 " << refd2 << ")" << endl;
+        return 1;
+      }
+
+      vector<pair<int, float> > within;
+      grid.ForEachWithin(eta, phi, radius, [&within](const int index, const float dr2) {
+        within.push_back(make_pair(index, dr2));
+      });
+      vector<pair<int, float> > refwithin;
+      for (unsigned int i = 0; i < npoints; i++)
+      {
+        const float dr2 = EtaPhiGrid::DeltaR2(eta, phi, points[i].eta, points[i].phi);
+        if (dr2 < radius * radius)
+        {
+          refwithin.push_back(make_pair(points[i].index, dr2));
+        }
+      }
+      sort(within.begin(), within.end());
+      if (within != refwithin)
+      {
+        cout << "event " << ievent << ": ForEachWithin(" << eta << ", " << phi << ", " << radius << ") cell size "
+             << cellsize << " found " << within.size() << " entries, expected " << refwithin.size() << endl;
+        return 1;
+      }
+      nchecks += 2;
+    }
+
+    grid.Match(queryeta, queryphi, radius, EtaPhiGrid::kClosest, match, matchdr2);
+    for (unsigned int q = 0; q < nqueries; q++)
+    {
+      float refd2;
+      const int ref = closest(points, queryeta[q], queryphi[q], radius, refd2);
+      if (!same(ref, refd2, match[q], matchdr2[q]))
+      {
+        cout << "event " << ievent << ": Match(kClosest) query " << q << " got " << match[q] << ", expected "
+             << ref << endl;
+        return 1;
+      }
+    }
+
+    grid.Match(queryeta, queryphi, radius, EtaPhiGrid::kOneToOneGreedy, match, matchdr2);
+    greedy(points, queryeta, queryphi, radius, refmatch, refdr2);
+    for (unsigned int q = 0; q < nqueries; q++)
+    {
+      if (!same(refmatch[q], refdr2[q], match[q], matchdr2[q]))
+      {
+        cout << "event " << ievent << ": Match(kOneToOneGreedy) query " << q << " got " << match[q]
+             << ", expected " << refmatch[q] << endl;
+        return 1;
+      }
+    }
+    nchecks += 2 * nqueries;
+  }
+  cout << "testetaphigrid: " << nevents << " events, " << nchecks << " searches agree with brute force" << endl;
+  return 0;
+}
@@ -18,15 +18,24 @@
 #include <calobase/RawCluster.h>
 #include <calobase/RawClusterContainer.h>
 
+#include <anautils/ColumnTree.h>
+#include <anautils/OutputPolicy.h>
+
 #include <fun4all/Fun4AllHistoManager.h>
 #include <fun4all/Fun4AllReturnCodes.h>
 
 #include <phool/getClass.h>
+#include <phool/phool.h>
 
 #include <TFile.h>
 #include <TNtuple.h>
+#include <TParameter.h>
+#include <TTree.h>
 
+#include <algorithm>
 #include <cassert>
+#include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 
@@ -34,24 +43,43 @@ using namespace std;
 
 CaloAna::CaloAna(const std::string& name, const std::string& filename)
   : SubsysReco(name)
-  , detector("HCALIN")
   , outfilename(filename)
+  , outputpolicy(new OutputPolicy())
   , hm(nullptr)
   , outfile(nullptr)
   , g4hitntuple(nullptr)
   , g4cellntuple(nullptr)
   , towerntuple(nullptr)
   , clusterntuple(nullptr)
+  , cellenergymap(false)
+  , hitthreshold(0.)
+  , hitperlayer(false)
+  , hitvoxelsize(0.)
+  , voxelntuple(nullptr)
+  , imageencoding(kDenseImage)
+  , imagechunk(1000)
+  , imagefile(nullptr)
+  , imagetree(nullptr)
+  , columnaroutput(false)
+  , eventtree(nullptr)
+  , hitcolumns(nullptr)
+  , cellcolumns(nullptr)
+  , towercolumns(nullptr)
+  , clustercolumns(nullptr)
+  , voxelcolumns(nullptr)
 {
 }
 
 CaloAna::~CaloAna()
 {
   delete hm;
+  delete outputpolicy;
   delete g4hitntuple;
   delete g4cellntuple;
   delete towerntuple;
   delete clusterntuple;
+  delete voxelntuple;
+  delete eventtree;
 }
 
 int CaloAna::Init(PHCompositeNode*)
@@ -60,14 +88,185 @@ int CaloAna::Init(PHCompositeNode*)
   // create and register your histos (all types) here
   // TH1 *h1 = new TH1F("h1",....)
   // hm->registerHisto(h1);
-  outfile = new TFile(outfilename.c_str(), "RECREATE");
-  g4hitntuple = new TNtuple("hitntup", "G4Hits", "x0:y0:z0:x1:y1:z1:edep");
-  g4cellntuple = new TNtuple("cellntup", "G4Cells", "phi:eta:edep");
-  towerntuple = new TNtuple("towerntup", "Towers", "phi:eta:energy");
-  clusterntuple = new TNtuple("clusterntup", "Clusters", "phi:z:energy:towers");
+  if (detectors.empty())
+  {
+    detectors.push_back("HCALIN");
+  }
+  // the detid column is the position in the list of detectors, the
+  // titles of the trees give the mapping
+  ostringstream detectorlist;
+  detectorlist << "detid";
+  detectornodes.resize(detectors.size());
+  for (unsigned int i = 0; i < detectors.size(); i++)
+  {
+    detectornodes[i].id = i;
+    detectornodes[i].imageetabins = 0;
+    detectornodes[i].imagephibins = 0;
+    detectornodes[i].nimagetowers = 0;
+    detectorlist << " " << i << ":" << detectors[i];
+  }
+  hitvoxels.SetPerLayer(hitperlayer);
+  hitvoxels.SetVoxelSize(hitvoxelsize);
+
+  if (!imagefilename.empty())
+  {
+    // the image sizes come from the tower geometry, the branches are
+    // added in InitRun. Opened before outfile, the trees below go there
+    imagefile = outputpolicy->OpenFile(imagefilename);
+    imagetree = new TTree("imagetree", ("Tower images, " + detectorlist.str()).c_str());
+  }
+  outfile = outputpolicy->OpenFile(outfilename);
+  if (columnaroutput)
+  {
+    // one entry per event, the hits of an event are collected in the
+    // columns and written with a single Fill at the end of process_event.
+    // Bins and tower counts stay integers
+    eventtree = new ColumnTree("eventtree", "Calorimeters, " + detectorlist.str());
+    hitcolumns = eventtree->AddCollection("hit");
+    hitcolumns->Add("x0", &hitrow.x0);
+    hitcolumns->Add("y0", &hitrow.y0);
+    hitcolumns->Add("z0", &hitrow.z0);
+    hitcolumns->Add("x1", &hitrow.x1);
+    hitcolumns->Add("y1", &hitrow.y1);
+    hitcolumns->Add("z1", &hitrow.z1);
+    hitcolumns->Add("edep", &hitrow.edep);
+    hitcolumns->Add("detid", &hitrow.detid);
+    cellcolumns = eventtree->AddCollection("cell");
+    cellcolumns->Add("phibin", &cellrow.phibin);
+    cellcolumns->Add("etabin", &cellrow.etabin);
+    cellcolumns->Add("edep", &cellrow.edep);
+    cellcolumns->Add("detid", &cellrow.detid);
+    towercolumns = eventtree->AddCollection("tower");
+    towercolumns->Add("phibin", &towerrow.phibin);
+    towercolumns->Add("etabin", &towerrow.etabin);
+    towercolumns->Add("phi", &towerrow.phi);
+    towercolumns->Add("eta", &towerrow.eta);
+    towercolumns->Add("energy", &towerrow.energy);
+    towercolumns->Add("detid", &towerrow.detid);
+    clustercolumns = eventtree->AddCollection("cluster");
+    clustercolumns->Add("phi", &clusterrow.phi);
+    clustercolumns->Add("z", &clusterrow.z);
+    clustercolumns->Add("energy", &clusterrow.energy);
+    clustercolumns->Add("towers", &clusterrow.towers);
+    clustercolumns->Add("detid", &clusterrow.detid);
+    if (hitvoxels.Active())
+    {
+      voxelcolumns = eventtree->AddCollection("voxel");
+      voxelcolumns->Add("x", &voxelrow.x);
+      voxelcolumns->Add("y", &voxelrow.y);
+      voxelcolumns->Add("z", &voxelrow.z);
+      voxelcolumns->Add("edep", &voxelrow.edep);
+      voxelcolumns->Add("nhits", &voxelrow.nhits);
+      voxelcolumns->Add("layer", &voxelrow.layer);
+      voxelcolumns->Add("detid", &voxelrow.detid);
+    }
+    outputpolicy->ApplyTo(eventtree->GetTree());
+    return 0;
+  }
+  g4hitntuple = new TNtuple("hitntup", ("G4Hits, " + detectorlist.str()).c_str(), "x0:y0:z0:x1:y1:z1:edep:detid");
+  g4cellntuple = new TNtuple("cellntup", ("G4Cells, " + detectorlist.str()).c_str(), "phi:eta:edep:detid");
+  towerntuple = new TNtuple("towerntup", ("Towers, " + detectorlist.str()).c_str(), "phi:eta:energy:detid");
+  clusterntuple = new TNtuple("clusterntup", ("Clusters, " + detectorlist.str()).c_str(), "phi:z:energy:towers:detid");
+  outputpolicy->ApplyTo(g4hitntuple);
+  outputpolicy->ApplyTo(g4cellntuple);
+  outputpolicy->ApplyTo(towerntuple);
+  outputpolicy->ApplyTo(clusterntuple);
+  if (hitvoxels.Active())
+  {
+    voxelntuple = new TNtuple("voxelntup", ("Summed G4Hits, " + detectorlist.str()).c_str(), "x:y:z:edep:nhits:layer:detid");
+    outputpolicy->ApplyTo(voxelntuple);
+  }
   return 0;
 }
 
+int CaloAna::InitRun(PHCompositeNode* topNode)
+{
+  // For the calorimeters we have the following node name convention
+  // where detector is the calorimeter name (CEMC, HCALIN, HCALOUT)
+  // The names are put together and looked up once here instead of
+  // in every event
+  for (unsigned int i = 0; i < detectors.size(); i++)
+  {
+    DetectorNodes& nodes = detectornodes[i];
+    nodes.g4hitnode.SetName("G4HIT_" + detectors[i]);
+    nodes.g4cellnode.SetName("G4CELL_" + detectors[i]);
+    nodes.towernode.SetName("TOWER_CALIB_" + detectors[i]);
+    nodes.towergeomnode.SetName("TOWERGEOM_" + detectors[i]);
+    nodes.clusternode.SetName("CLUSTER_" + detectors[i]);
+
+    nodes.g4hitnode.Resolve(topNode);
+    nodes.g4cellnode.Resolve(topNode);
+    nodes.towernode.Resolve(topNode);
+    nodes.clusternode.Resolve(topNode);
+
+    // the tower geometry can change between runs
+    nodes.towergeomtable.Build(nodes.towergeomnode.Resolve(topNode));
+  }
+  if (imagetree)
+  {
+    return book_images();
+  }
+  return Fun4AllReturnCodes::EVENT_OK;
+}
+
+int CaloAna::book_images()
+{
+  // the shape of the images is fixed by the first run, the towers of a
+  // later run have to fit into it
+  if (imagetree->GetNbranches() > 0)
+  {
+    for (unsigned int i = 0; i < detectors.size(); i++)
+    {
+      const DetectorNodes& nodes = detectornodes[i];
+      if (nodes.imageetabins > 0 &&
+          (nodes.towergeomtable.EtaBins() != nodes.imageetabins || nodes.towergeomtable.PhiBins() != nodes.imagephibins))
+      {
+        cout << PHWHERE << " tower geometry of " << detectors[i] << " changed from "
+             << nodes.imageetabins << " x " << nodes.imagephibins << " to " << nodes.towergeomtable.EtaBins()
+             << " x " << nodes.towergeomtable.PhiBins() << ", the images cannot change their shape" << endl;
+        return Fun4AllReturnCodes::ABORTRUN;
+      }
+    }
+    return Fun4AllReturnCodes::EVENT_OK;
+  }
+  for (unsigned int i = 0; i < detectors.size(); i++)
+  {
+    DetectorNodes& nodes = detectornodes[i];
+    const int etabins = nodes.towergeomtable.EtaBins();
+    const int phibins = nodes.towergeomtable.PhiBins();
+    if (etabins <= 0 || phibins <= 0)
+    {
+      cout << PHWHERE << " no tower geometry for " << detectors[i] << ", no images for it" << endl;
+      continue;
+    }
+    nodes.imageetabins = etabins;
+    nodes.imagephibins = phibins;
+    nodes.image.assign(etabins * phibins, 0);
+    const string& prefix = detectors[i];
+    imagetree->GetUserInfo()->Add(new TParameter<int>((prefix + "_etabins").c_str(), etabins));
+    imagetree->GetUserInfo()->Add(new TParameter<int>((prefix + "_phibins").c_str(), phibins));
+    if (imageencoding == kSparseImage)
+    {
+      nodes.imageindex.resize(etabins * phibins);
+      nodes.imageenergy.resize(etabins * phibins);
+      imagetree->Branch((prefix + "_ntowers").c_str(), &nodes.nimagetowers, (prefix + "_ntowers/I").c_str());
+      imagetree->Branch((prefix + "_index").c_str(), &nodes.imageindex[0],
+                        (prefix + "_index[" + prefix + "_ntowers]/I").c_str());
+      imagetree->Branch((prefix + "_energy").c_str(), &nodes.imageenergy[0],
+                        (prefix + "_energy[" + prefix + "_ntowers]/F").c_str());
+    }
+    else
+    {
+      ostringstream leaf;
+      leaf << prefix << "_image[" << etabins << "][" << phibins << "]/F";
+      imagetree->Branch((prefix + "_image").c_str(), &nodes.image[0], leaf.str().c_str());
+    }
+  }
+  outputpolicy->ApplyTo(imagetree);
+  imagetree->SetAutoFlush(imagechunk);
+  return Fun4AllReturnCodes::EVENT_OK;
+}
+
 int CaloAna::process_event(PHCompositeNode* topNode)
 {
   // For the calorimeters we have the following node name convention
@@ -79,36 +278,107 @@ int CaloAna::process_event(PHCompositeNode* topNode)
   //  TOWER_RAW_<detector>: Raw Tower (adc/tdc values - from sims or real data)
   //  TOWER_CALIB_<detector>: Calibrated towers
   //  CLUSTER_<detector>: clusters
+  // all detectors are done in one pass, the detector of an entry is
+  // given by its detid
   process_g4hits(topNode);
   process_g4cells(topNode);
   process_towers(topNode);
   process_clusters(topNode);
+  if (imagetree)
+  {
+    process_images(topNode);
+  }
+  if (eventtree)
+  {
+    eventtree->Fill();
+  }
   return Fun4AllReturnCodes::EVENT_OK;
 }
 
 int CaloAna::process_g4hits(PHCompositeNode* topNode)
 {
-  ostringstream nodename;
-
-  // loop over the G4Hits
-  nodename.str("");
-  nodename << "G4HIT_" << detector;
-  PHG4HitContainer* hits = findNode::getClass<PHG4HitContainer>(topNode, nodename.str().c_str());
-  if (hits)
+  for (vector<DetectorNodes>::iterator nodes = detectornodes.begin(); nodes != detectornodes.end(); ++nodes)
   {
+    // loop over the G4Hits
+    PHG4HitContainer* hits = nodes->g4hitnode.Get(topNode);
+    if (!hits)
+    {
+      continue;
+    }
+    // with the hits summed per layer or voxel only the sums are written
+    const bool sum = hitvoxels.Active();
+    if (sum)
+    {
+      hitvoxels.Clear();
+    }
     // this returns an iterator to the beginning and the end of our G4Hits
     PHG4HitContainer::ConstRange hit_range = hits->getHits();
     for (PHG4HitContainer::ConstIterator hit_iter = hit_range.first; hit_iter != hit_range.second; hit_iter++)
 
     {
       // the pointer to the G4Hit is hit_iter->second
-      g4hitntuple->Fill(hit_iter->second->get_x(0),
-                        hit_iter->second->get_y(0),
-                        hit_iter->second->get_z(0),
-                        hit_iter->second->get_x(1),
-                        hit_iter->second->get_y(1),
-                        hit_iter->second->get_z(1),
-                        hit_iter->second->get_edep());
+      const PHG4Hit* hit = hit_iter->second;
+      const double edep = hit->get_edep();
+      if (edep < hitthreshold)
+      {
+        continue;
+      }
+      if (sum)
+      {
+        hitvoxels.Add(hit->get_layer(),
+                      0.5 * (hit->get_x(0) + hit->get_x(1)),
+                      0.5 * (hit->get_y(0) + hit->get_y(1)),
+                      0.5 * (hit->get_z(0) + hit->get_z(1)),
+                      edep);
+        continue;
+      }
+      if (hitcolumns)
+      {
+        hitrow.x0 = hit->get_x(0);
+        hitrow.y0 = hit->get_y(0);
+        hitrow.z0 = hit->get_z(0);
+        hitrow.x1 = hit->get_x(1);
+        hitrow.y1 = hit->get_y(1);
+        hitrow.z1 = hit->get_z(1);
+        hitrow.edep = edep;
+        hitrow.detid = nodes->id;
+        hitcolumns->AppendRow();
+        continue;
+      }
+      g4hitntuple->Fill(hit->get_x(0),
+                        hit->get_y(0),
+                        hit->get_z(0),
+                        hit->get_x(1),
+                        hit->get_y(1),
+                        hit->get_z(1),
+                        edep,
+                        nodes->id);
+    }
+    if (!sum)
+    {
+      continue;
+    }
+    for (unsigned int i = 0; i < hitvoxels.Size(); i++)
+    {
+      if (voxelcolumns)
+      {
+        voxelrow.x = hitvoxels.X(i);
+        voxelrow.y = hitvoxels.Y(i);
+        voxelrow.z = hitvoxels.Z(i);
+        voxelrow.edep = hitvoxels.Edep(i);
+        voxelrow.nhits = hitvoxels.Deposits(i);
+        voxelrow.layer = hitvoxels.Layer(i);
+        voxelrow.detid = nodes->id;
+        voxelcolumns->AppendRow();
+        continue;
+      }
+      voxelntuple->Fill(hitvoxels.X(i),
+                        hitvoxels.Y(i),
+                        hitvoxels.Z(i),
+                        hitvoxels.Edep(i),
+                        hitvoxels.Deposits(i),
+                        hitvoxels.Layer(i),
+                        nodes->id);
     }
   }
   return Fun4AllReturnCodes::EVENT_OK;
@@ -116,42 +386,37 @@ int CaloAna::process_g4hits(PHCompositeNode* topNode)
 
 int CaloAna::process_g4cells(PHCompositeNode* topNode)
 {
-  ostringstream nodename;
-
-  // loop over the G4Hits
-  nodename.str("");
-  nodename << "G4CELL_" << detector;
-  PHG4CellContainer* cells = findNode::getClass<PHG4CellContainer>(topNode, nodename.str());
-  if (cells)
+  for (vector<DetectorNodes>::iterator nodes = detectornodes.begin(); nodes != detectornodes.end(); ++nodes)
   {
-    PHG4CellContainer::ConstRange cell_range = cells->getCells();
-    int phibin = -999;
-    int etabin = -999;
-    for (PHG4CellContainer::ConstIterator cell_iter = cell_range.first; cell_iter != cell_range.second; cell_iter++)
+    // loop over the G4Cells
+    PHG4CellContainer* cells = nodes->g4cellnode.Get(topNode);
+    if (!cells)
     {
-      if (cell_iter->second->has_binning(PHG4CellDefs::scintillatorslatbinning))
-      {
-        phibin = PHG4CellDefs::ScintillatorSlatBinning::get_row(cell_iter->second->get_cellid());
-        etabin = PHG4CellDefs::ScintillatorSlatBinning::get_column(cell_iter->second->get_cellid());
-      }
-      else if (cell_iter->second->has_binning(PHG4CellDefs::sizebinning))
-      {
-        phibin = PHG4CellDefs::SizeBinning::get_phibin(cell_iter->second->get_cellid());
-        etabin = PHG4CellDefs::SizeBinning::get_zbin(cell_iter->second->get_cellid());
-      }
-      else if (cell_iter->second->has_binning(PHG4CellDefs::spacalbinning))
-      {
-        phibin = PHG4CellDefs::SpacalBinning::get_phibin(cell_iter->second->get_cellid());
-        etabin = PHG4CellDefs::SpacalBinning::get_etabin(cell_iter->second->get_cellid());
-      }
-      else
+      continue;
+    }
+    // all cell ids are decoded in one go for the binning of this container
+    CellDecoder& decoder = nodes->celldecoder;
+    decoder.Decode(cells);
+    if (cellenergymap)
+    {
+      decoder.Aggregate();
+    }
+    for (unsigned int i = 0; i < decoder.Size(); i++)
+    {
+      if (cellcolumns)
       {
-        cout << "unknown cell binning, implement 0x" << hex << PHG4CellDefs::get_binning(cell_iter->second->get_cellid()) << dec << endl;
+        cellrow.phibin = decoder.PhiBin(i);
+        cellrow.etabin = decoder.EtaBin(i);
+        cellrow.edep = decoder.Edep(i);
+        cellrow.detid = nodes->id;
+        cellcolumns->AppendRow();
+        continue;
       }
       g4cellntuple->Fill(
-          phibin,
-          etabin,
-          cell_iter->second->get_edep());
+          decoder.PhiBin(i),
+          decoder.EtaBin(i),
+          decoder.Edep(i),
+          nodes->id);
     }
   }
   return Fun4AllReturnCodes::EVENT_OK;
@@ -159,22 +424,18 @@ int CaloAna::process_g4cells(PHCompositeNode* topNode)
 
 int CaloAna::process_towers(PHCompositeNode* topNode)
 {
-  ostringstream nodename;
-  ostringstream geonodename;
-
-  // loop over the G4Hits
-  nodename.str("");
-  nodename << "TOWER_CALIB_" << detector;
-  geonodename.str("");
-  geonodename << "TOWERGEOM_" << detector;
-  RawTowerGeomContainer* towergeom = findNode::getClass<RawTowerGeomContainer>(topNode, geonodename.str().c_str());
-  if (!towergeom)
-  {
-    return Fun4AllReturnCodes::EVENT_OK;
-  }
-  RawTowerContainer* towers = findNode::getClass<RawTowerContainer>(topNode, nodename.str().c_str());
-  if (towers)
+  for (vector<DetectorNodes>::iterator nodes = detectornodes.begin(); nodes != detectornodes.end(); ++nodes)
   {
+    // loop over the towers
+    RawTowerGeomContainer* towergeom = nodes->towergeomnode.Get(topNode);
+    RawTowerContainer* towers = nodes->towernode.Get(topNode);
+    if (!towergeom || !towers)
+    {
+      continue;
+    }
+    // the geometry lookups are map searches behind virtual calls, the
+    // table has the bin centers in flat arrays
+    nodes->towergeomtable.Update(towergeom);
     // again pair of iterators to begin and end of tower map
     RawTowerContainer::ConstRange tower_range = towers->getTowers();
     for (RawTowerContainer::ConstIterator tower_iter = tower_range.first; tower_iter != tower_range.second; tower_iter++)
@@ -182,11 +443,33 @@ int CaloAna::process_towers(PHCompositeNode* topNode)
     {
       int phibin = tower_iter->second->get_binphi();
       int etabin = tower_iter->second->get_bineta();
-      double phi = towergeom->get_phicenter(phibin);
-      double eta = towergeom->get_etacenter(etabin);
+      double phi;
+      double eta;
+      if (nodes->towergeomtable.Contains(etabin, phibin))
+      {
+        phi = nodes->towergeomtable.Phi(etabin, phibin);
+        eta = nodes->towergeomtable.Eta(etabin, phibin);
+      }
+      else
+      {
+        phi = towergeom->get_phicenter(phibin);
+        eta = towergeom->get_etacenter(etabin);
+      }
+      if (towercolumns)
+      {
+        towerrow.phibin = phibin;
+        towerrow.etabin = etabin;
+        towerrow.phi = phi;
+        towerrow.eta = eta;
+        towerrow.energy = tower_iter->second->get_energy();
+        towerrow.detid = nodes->id;
+        towercolumns->AppendRow();
+        continue;
+      }
       towerntuple->Fill(phi,
                         eta,
-                        tower_iter->second->get_energy());
+                        tower_iter->second->get_energy(),
+                        nodes->id);
     }
   }
   return Fun4AllReturnCodes::EVENT_OK;
@@ -194,36 +477,138 @@ int CaloAna::process_towers(PHCompositeNode* topNode)
 
 int CaloAna::process_clusters(PHCompositeNode* topNode)
 {
-  ostringstream nodename;
-
-  // loop over the G4Hits
-  nodename.str("");
-  nodename << "CLUSTER_" << detector;
-  RawClusterContainer* clusters = findNode::getClass<RawClusterContainer>(topNode, nodename.str().c_str());
-  if (clusters)
+  for (vector<DetectorNodes>::iterator nodes = detectornodes.begin(); nodes != detectornodes.end(); ++nodes)
   {
+    // loop over the clusters
+    RawClusterContainer* clusters = nodes->clusternode.Get(topNode);
+    if (!clusters)
+    {
+      continue;
+    }
     RawClusterContainer::ConstRange cluster_range = clusters->getClusters();
     for (RawClusterContainer::ConstIterator cluster_iter = cluster_range.first; cluster_iter != cluster_range.second; cluster_iter++)
     {
+      if (clustercolumns)
+      {
+        clusterrow.phi = cluster_iter->second->get_phi();
+        clusterrow.z = cluster_iter->second->get_z();
+        clusterrow.energy = cluster_iter->second->get_energy();
+        clusterrow.towers = cluster_iter->second->getNTowers();
+        clusterrow.detid = nodes->id;
+        clustercolumns->AppendRow();
+        continue;
+      }
       clusterntuple->Fill(cluster_iter->second->get_phi(),
                           cluster_iter->second->get_z(),
                           cluster_iter->second->get_energy(),
-                          cluster_iter->second->getNTowers());
+                          cluster_iter->second->getNTowers(),
+                          nodes->id);
     }
   }
   return Fun4AllReturnCodes::EVENT_OK;
 }
 
+int CaloAna::process_images(PHCompositeNode* topNode)
+{
+  for (vector<DetectorNodes>::iterator nodes = detectornodes.begin(); nodes != detectornodes.end(); ++nodes)
+  {
+    if (nodes->imageetabins == 0)
+    {
+      continue;
+    }
+    // an event without towers is an empty image
+    fill(nodes->image.begin(), nodes->image.end(), 0.);
+    nodes->nimagetowers = 0;
+    RawTowerContainer* towers = nodes->towernode.Get(topNode);
+    if (towers)
+    {
+      float* image = &nodes->image[0];
+      const unsigned int etabins = nodes->imageetabins;
+      const unsigned int phibins = nodes->imagephibins;
+      RawTowerContainer::ConstRange tower_range = towers->getTowers();
+      for (RawTowerContainer::ConstIterator tower_iter = tower_range.first; tower_iter != tower_range.second; tower_iter++)
+      {
+        const unsigned int etabin = tower_iter->second->get_bineta();
+        const unsigned int phibin = tower_iter->second->get_binphi();
+        if (etabin < etabins && phibin < phibins)
+        {
+          image[etabin * phibins + phibin] += tower_iter->second->get_energy();
+        }
+      }
+    }
+    if (imageencoding == kSparseImage)
+    {
+      const int ntowers = nodes->image.size();
+      for (int j = 0; j < ntowers; j++)
+      {
+        if (nodes->image[j] != 0)
+        {
+          nodes->imageindex[nodes->nimagetowers] = j;
+          nodes->imageenergy[nodes->nimagetowers] = nodes->image[j];
+          nodes->nimagetowers++;
+        }
+      }
+    }
+  }
+  // without any image branch there is nothing to fill
+  if (imagetree->GetNbranches() > 0)
+  {
+    imagetree->Fill();
+  }
+  return Fun4AllReturnCodes::EVENT_OK;
+}
+
 int CaloAna::End(PHCompositeNode* topNode)
 {
+  // cells we could not decode were stored with bins -999, say so once
+  for (unsigned int i = 0; i < detectornodes.size(); i++)
+  {
+    const map<int, unsigned long>& unknown = detectornodes[i].celldecoder.UnknownCells();
+    for (map<int, unsigned long>::const_iterator iter = unknown.begin(); iter != unknown.end(); ++iter)
+    {
+      cout << Name() << ": " << iter->second << " cells of " << detectors[i]
+           << " with unknown cell binning, implement 0x" << hex << iter->first << dec << endl;
+    }
+  }
+  if (imagefile)
+  {
+    imagefile->cd();
+    imagetree->Write();
+    imagefile->Close();
+    delete imagefile;
+    imagefile = nullptr;
+    imagetree = nullptr;
+    outputpolicy->Finish(imagefilename);
+  }
   outfile->cd();
-  g4hitntuple->Write();
-  g4cellntuple->Write();
-  towerntuple->Write();
-  clusterntuple->Write();
+  // in columnar mode only the eventtree exists, it is saved by the file
+  if (!eventtree)
+  {
+    g4hitntuple->Write();
+    g4cellntuple->Write();
+    towerntuple->Write();
+    clusterntuple->Write();
+    if (voxelntuple)
+    {
+      voxelntuple->Write();
+    }
+  }
   outfile->Write();
   outfile->Close();
   delete outfile;
-  hm->dumpHistos(outfilename, "UPDATE");
+  outfile = nullptr;
+  // closing the file deleted the ntuples it owned
+  g4hitntuple = nullptr;
+  g4cellntuple = nullptr;
+  towerntuple = nullptr;
+  clusterntuple = nullptr;
+  voxelntuple = nullptr;
+  hm->dumpHistos(outputpolicy->LocalFileName(outfilename), "UPDATE");
+  outputpolicy->Finish(outfilename);
   return 0;
 }
+
+void CaloAna::SetOutputPolicy(const OutputPolicy& policy)
+{
+  *outputpolicy = policy;
+}
@@ -3,11 +3,30 @@
 
 #include <fun4all/SubsysReco.h>
 
+#include <string>
+#include <vector>
+
+#if !defined(__CINT__) || defined(__CLING__)
+#include <anautils/CellDecoder.h>
+#include <anautils/NodeHandle.h>
+#include <anautils/TowerGeomTable.h>
+#include <anautils/VoxelAccumulator.h>
+#endif
+
 // Forward declarations
+class ColumnCollection;
+class ColumnTree;
 class Fun4AllHistoManager;
+class OutputPolicy;
 class PHCompositeNode;
+class PHG4CellContainer;
+class PHG4HitContainer;
+class RawClusterContainer;
+class RawTowerContainer;
+class RawTowerGeomContainer;
 class TFile;
 class TNtuple;
+class TTree;
 
 class CaloAna : public SubsysReco
 {
@@ -21,6 +40,9 @@ class CaloAna : public SubsysReco
   //! full initialization
   int Init(PHCompositeNode *);
 
+  //! run initialization, looks up the nodes of the detector
+  int InitRun(PHCompositeNode *);
+
   //! event processing method
   int process_event(PHCompositeNode *);
 
@@ -31,18 +53,162 @@ class CaloAna : public SubsysReco
   int process_g4cells(PHCompositeNode *);
   int process_towers(PHCompositeNode *);
   int process_clusters(PHCompositeNode *);
+  int process_images(PHCompositeNode *);
+
+  //! how the tower images are stored
+  enum ImageEncoding
+  {
+    //! the full (etabin, phibin) array, <detector>_image[etabins][phibins]
+    kDenseImage = 0,
+    //! only the towers with energy, <detector>_ntowers, <detector>_index
+    //! (etabin * phibins + phibin) and <detector>_energy. Smaller as long
+    //! as less than about half of the towers have energy
+    kSparseImage = 1
+  };
+
+  //! analyze only this detector (default HCALIN)
+  void Detector(const std::string &name)
+  {
+    detectors.clear();
+    detectors.push_back(name);
+  }
+  //! analyze this detector as well, all detectors are processed in one pass
+  //! into the same output, the detid column is the position in this list
+  void AddDetector(const std::string &name) { detectors.push_back(name); }
+
+  //! compression, basket size, auto flush and scratch directory of the output
+  void SetOutputPolicy(const OutputPolicy &policy);
+
+  //! write one entry per event with typed vector columns (tree "eventtree")
+  //! instead of one float TNtuple entry per hit, cell, tower and cluster
+  void SetColumnarOutput(const bool b) { columnaroutput = b; }
+
+  //! sum the G4Cells of an event per (phibin, etabin) and write one cell
+  //! entry per bin instead of one per cell (the spacal has many fibers,
+  //! each its own cell, in one bin)
+  void SetCellEnergyMap(const bool b) { cellenergymap = b; }
+
+  //! G4Hits with less edep (GeV) are neither written nor summed
+  void SetHitThreshold(const double e) { hitthreshold = e; }
+  //! write the summed edep of the G4Hits per layer of each detector
+  //! (PHG4Hit::get_layer, the scintillator layer in the HCALs) instead of
+  //! the hits. Goes into the tree voxelntup (or the voxel columns), x, y, z
+  //! are the energy weighted mean of the hit midpoints (cm)
+  void SetHitSumPerLayer(const bool b) { hitperlayer = b; }
+  //! same with the hits summed per cubic voxel of this size (cm), together
+  //! with SetHitSumPerLayer(true) the voxels do not cross layers
+  void SetHitVoxelSize(const double size) { hitvoxelsize = size; }
 
-  void Detector(const std::string &name) { detector = name; }
+  //! write the calibrated towers of every detector as an image with the
+  //! dimensions of its tower geometry, one entry per event in the tree
+  //! "imagetree" of this file. The entries are flushed in chunks of
+  //! chunkevents events, a reader gets a whole chunk with one read.
+  //! This is written in addition to the other output
+  void SetImageOutput(const std::string &fname, const int encoding = kDenseImage, const int chunkevents = 1000)
+  {
+    imagefilename = fname;
+    imageencoding = encoding;
+    imagechunk = chunkevents;
+  }
 
  protected:
-  std::string detector;
+  //! add the image branches in the first run, check the shape in later ones
+  int book_images();
+
+  std::vector<std::string> detectors;
   std::string outfilename;
+  OutputPolicy *outputpolicy;
   Fun4AllHistoManager *hm;
   TFile *outfile;
   TNtuple *g4hitntuple;
   TNtuple *g4cellntuple;
   TNtuple *towerntuple;
   TNtuple *clusterntuple;
+  bool cellenergymap;
+
+  // G4Hit reduction
+  double hitthreshold;
+  bool hitperlayer;
+  double hitvoxelsize;
+  TNtuple *voxelntuple;
+
+  // tower images
+  std::string imagefilename;
+  int imageencoding;
+  int imagechunk;
+  TFile *imagefile;
+  TTree *imagetree;
+
+  // columnar output, the columns are bound to the rows below
+  bool columnaroutput;
+  ColumnTree *eventtree;
+  ColumnCollection *hitcolumns;
+  ColumnCollection *cellcolumns;
+  ColumnCollection *towercolumns;
+  ColumnCollection *clustercolumns;
+  ColumnCollection *voxelcolumns;
+  struct HitRow
+  {
+    double x0, y0, z0, x1, y1, z1, edep;
+    int detid;
+  } hitrow;
+  struct VoxelRow
+  {
+    double x, y, z, edep;
+    int nhits, layer;
+    int detid;
+  } voxelrow;
+  struct CellRow
+  {
+    int phibin, etabin;
+    double edep;
+    int detid;
+  } cellrow;
+  struct TowerRow
+  {
+    int phibin, etabin;
+    double phi, eta, energy;
+    int detid;
+  } towerrow;
+  struct ClusterRow
+  {
+    double phi, z, energy;
+    int towers;
+    int detid;
+  } clusterrow;
+
+#if !defined(__CINT__) || defined(__CLING__)
+  // node handles of one detector, the names depend on the detector
+  struct DetectorNodes
+  {
+    int id;
+    NodeHandle<PHG4HitContainer> g4hitnode;
+    NodeHandle<PHG4CellContainer> g4cellnode;
+    NodeHandle<RawTowerContainer> towernode;
+    NodeHandle<RawTowerGeomContainer> towergeomnode;
+    NodeHandle<RawClusterContainer> clusternode;
+
+    // cell bins, the binning of the container is determined once per event
+    CellDecoder celldecoder;
+
+    // tower centers, rebuilt when the geometry node changes
+    TowerGeomTable towergeomtable;
+
+    // tower image, index etabin * phibins + phibin, and the towers with
+    // energy for the sparse encoding. The branches of the imagetree point
+    // to these
+    int imageetabins;
+    int imagephibins;
+    std::vector<float> image;
+    int nimagetowers;
+    std::vector<int> imageindex;
+    std::vector<float> imageenergy;
+  };
+  std::vector<DetectorNodes> detectornodes;
+
+  // sums of the G4Hits of one detector, reused for all detectors
+  VoxelAccumulator hitvoxels;
+#endif
 };
 
 #endif
@@ -6,6 +6,8 @@
 #include <fun4all/Fun4AllHistoManager.h>
 #include <fun4all/Fun4AllReturnCodes.h>
 
+#include <anautils/HistoBuffer.h>
+
 #include <phool/getClass.h>
 #include <phool/PHCompositeNode.h>
 
@@ -14,11 +16,23 @@
 
 using namespace std;
 
-AnalyzeSimpleTree::AnalyzeSimpleTree(const string &name): SubsysReco(name)
+AnalyzeSimpleTree::AnalyzeSimpleTree(const string &name):
+  SubsysReco(name),
+  hm(nullptr),
+  myfloats(nullptr),
+  my2dfloats(nullptr),
+  myfloatsbuffer(nullptr),
+  my2dfloatsbuffer(nullptr)
 {
   return ;
 }
 
+AnalyzeSimpleTree::~AnalyzeSimpleTree()
+{
+  delete myfloatsbuffer;
+  delete my2dfloatsbuffer;
+}
+
 int
 AnalyzeSimpleTree::Init(PHCompositeNode *topNode)
 {
@@ -37,6 +51,11 @@ AnalyzeSimpleTree::Init(PHCompositeNode *topNode)
   // the names you gave to the histograms when you created them.
   hm->registerHisto(myfloats);
   hm->registerHisto(my2dfloats);
+  // filling a histogram value by value means a virtual call and a bin
+  // search for every value. The buffers collect the values and fill
+  // them in one go, do not forget to flush them at the end (see End())
+  myfloatsbuffer = new HistoBuffer(myfloats);
+  my2dfloatsbuffer = new HistoBuffer(my2dfloats);
   return 0;
 }
 
@@ -45,14 +64,23 @@ AnalyzeSimpleTree::process_event(PHCompositeNode *topNode)
 {
   // Find the object on the node tree and fill some of its content into a histogram
   MySimpleTree *mytree = findNode::getClass<MySimpleTree>(topNode, "MYSIMPLETREE");
-  myfloats->Fill(mytree->MyFloat());
+  myfloatsbuffer->Fill(mytree->MyFloat());
   // for TClonesArrays we need to loop over its Entries, get a pointer to the class
   // which is stored inside it and then use that pointer to fill a histogram
   MyTClonesArray *mycontainer = findNode::getClass<MyTClonesArray>(topNode, "MYTCARRAY");
   for (int j = 0; j < mycontainer->Entries();j++)
     {
       MySimpleTree *item = mycontainer->GetItem(j);
-      my2dfloats->Fill(mytree->MyFloat(), item->MyFloat());
+      my2dfloatsbuffer->Fill(mytree->MyFloat(), item->MyFloat());
     }
   return Fun4AllReturnCodes::EVENT_OK;
 }
+
+int
+AnalyzeSimpleTree::End(PHCompositeNode *topNode)
+{
+  // the histograms are saved after End(), they need all values by then
+  myfloatsbuffer->Flush();
+  my2dfloatsbuffer->Flush();
+  return 0;
+}
@@ -4,6 +4,7 @@
 #include <fun4all/SubsysReco.h>
 
 class Fun4AllHistoManager;
+class HistoBuffer;
 class TH1;
 class TH2;
 
@@ -12,17 +13,22 @@ class AnalyzeSimpleTree: public SubsysReco
  public:
 
   AnalyzeSimpleTree(const std::string &name = "ANALYZETREE");
-  virtual ~AnalyzeSimpleTree() {}
+  virtual ~AnalyzeSimpleTree();
 
   int Init(PHCompositeNode *topNode);
 
   int process_event(PHCompositeNode *topNode);
 
+  int End(PHCompositeNode *topNode);
+
  protected:
 
   Fun4AllHistoManager *hm;
   TH1 *myfloats;
   TH2 *my2dfloats;
+  // collect the values and fill the histograms in batches
+  HistoBuffer *myfloatsbuffer;
+  HistoBuffer *my2dfloatsbuffer;
 };
 
 #endif /* ANALYZESIMPLETREE_H__ */
@@ -1,7 +1,11 @@
 #include "MakeSimpleTree.h"
 #include "MySimpleTree.h"
+#include "MySimpleTreeArray.h"
+#include "MySimpleTreeColumns.h"
 #include "MyTClonesArray.h"
 
+#include <anautils/EventIndex.h>
+
 #include <fun4all/Fun4AllReturnCodes.h>
 
 #include <phool/getClass.h>
@@ -9,13 +13,33 @@
 #include <phool/PHIODataNode.h>
 #include <phool/PHNodeIterator.h>
 
+#include <TRandom3.h>
+
 using namespace std;
 
-MakeSimpleTree::MakeSimpleTree(const string &name): SubsysReco(name)
+MakeSimpleTree::MakeSimpleTree(const string &name):
+  SubsysReco(name),
+  firstevent(0),
+  eventnumber(0),
+  payloadmode(kRamp),
+  payloadsize(0),
+  seed(4711),
+  random(new TRandom3()),
+  filleventindex(false),
+  discardevents(true),
+  eventindex(0),
+  eventnumberscalar(-1),
+  nitemsscalar(-1),
+  oddeventflag(-1)
 {
   return;
 }
 
+MakeSimpleTree::~MakeSimpleTree()
+{
+  delete random;
+}
+
 int
 MakeSimpleTree::Init(PHCompositeNode *topNode)
 {
@@ -42,27 +66,100 @@ MakeSimpleTree::Init(PHCompositeNode *topNode)
   MyTClonesArray *mycontainer = new MyTClonesArray();
   newNode = new PHIODataNode <PHObject>(mycontainer,"MYTCARRAY","PHObject");
   dstNode->addNode(newNode);
+  // the same content in the generic container which keeps its objects
+  // between events
+  MySimpleTreeArray *mypool = new MySimpleTreeArray();
+  newNode = new PHIODataNode <PHObject>(mypool,"MYPOOLARRAY","PHObject");
+  dstNode->addNode(newNode);
+  // and once more with one array per member, readers can pick the
+  // members they need
+  MySimpleTreeColumns *mycolumns = new MySimpleTreeColumns();
+  newNode = new PHIODataNode <PHObject>(mycolumns,"MYCOLUMNS","PHObject");
+  dstNode->addNode(newNode);
+  // the event counter belongs to this instance, a second MakeSimpleTree
+  // (or a second job with a different first event) counts on its own
+  eventnumber = firstevent;
+  // one row per event, an output manager with the same event selector
+  // writes it into a small companion file for fast skims
+  if (filleventindex)
+    {
+      eventindex = EventIndex::GetOrCreate(topNode);
+      if (eventindex)
+        {
+          eventnumberscalar = eventindex->RegisterIntScalar("eventnumber");
+          nitemsscalar = eventindex->RegisterIntScalar("nitems");
+          oddeventflag = eventindex->RegisterFlag("oddevent");
+        }
+    }
   return 0;
 }
 
+unsigned int
+MakeSimpleTree::EventSeed(const int n) const
+{
+  // mix seed and event number (splitmix64) so neighbouring events do not
+  // get neighbouring seeds
+  unsigned long long z = (static_cast<unsigned long long>(seed) << 32) + static_cast<unsigned int>(n);
+  z += 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  unsigned int eventseed = z & 0xffffffff;
+  // TRandom3 takes seed 0 as "make one up"
+  return (eventseed) ? eventseed : 1;
+}
+
+int
+MakeSimpleTree::PayloadSize(const int n)
+{
+  switch (payloadmode)
+    {
+    case kFixed:
+      return static_cast<int>(payloadsize);
+    case kPoisson:
+      // reseeding per event makes the size independent of which
+      // events this job made before
+      random->SetSeed(EventSeed(n));
+      return random->Poisson(payloadsize);
+    case kRamp:
+    default:
+      return (payloadsize >= 1) ? n % static_cast<int>(payloadsize) : n;
+    }
+}
+
 int
 MakeSimpleTree::process_event(PHCompositeNode *topNode)
 {
-  static int i = 0;
+  const int i = eventnumber;
   MySimpleTree *mytree = findNode::getClass<MySimpleTree>(topNode,"MYSIMPLETREE");
   float f = i;
   mytree->MyFloat(f);
   mytree->MyInt(i);
    MyTClonesArray *mycontainer = findNode::getClass<MyTClonesArray>(topNode,"MYTCARRAY");
-   for (int j=0; j<i;j++)
+   MySimpleTreeArray *mypool = findNode::getClass<MySimpleTreeArray>(topNode,"MYPOOLARRAY");
+   const int nitems = PayloadSize(i);
+   for (int j=0; j<nitems;j++)
      {
        MySimpleTree *item = mycontainer->GetNewItem();
        item->MyFloat(f);
        item->MyInt(i);
+       item = mypool->GetNewItem();
+       item->MyFloat(f);
+       item->MyInt(i);
      }
    mycontainer->MyEventInt(i);
    mycontainer->MyEventFloat(f);
-   i++;
+   mypool->MyEventInt(i);
+   mypool->MyEventFloat(f);
+   MySimpleTreeColumns *mycolumns = findNode::getClass<MySimpleTreeColumns>(topNode,"MYCOLUMNS");
+   mycolumns->Fill(*mypool);
+   if (eventindex)
+     {
+       eventindex->SetIntScalar(eventnumberscalar, i);
+       eventindex->SetIntScalar(nitemsscalar, nitems);
+       eventindex->SetFlag(oddeventflag, i % 2);
+     }
+   eventnumber++;
    // Fun4All looks at the return codes from each module
    // DISCARDEVENT tells an output manager which has this module
    // added to its "EventSelector" not to write this event out
@@ -72,7 +169,8 @@ MakeSimpleTree::process_event(PHCompositeNode *topNode)
    // 
    // EVENT_OK tells Fun4All all went well
    // This code just drops every other event from the output
-   if (i % 2)
+   // (unless the selection only goes into the event index)
+   if (discardevents && (eventnumber % 2))
      {
        return Fun4AllReturnCodes::DISCARDEVENT;
      }
@@ -3,21 +3,66 @@
 
 #include <fun4all/SubsysReco.h>
 
+class EventIndex;
+class TRandom3;
+
+// Fills the MySimpleTree and the containers on the DST node with a
+// configurable number of items per event, which makes it a simple load
+// generator for the DST I/O. The number of items of an event depends only
+// on the payload settings, the seed and the event number. So jobs which
+// make disjoint event ranges (SetFirstEvent()) produce files which merged
+// together contain exactly what a single job over the whole range makes.
 class MakeSimpleTree: public SubsysReco
 {
  public:
 
+  enum PayloadMode
+  {
+    kRamp = 0,    // event n has n items (n % size if size > 0)
+    kFixed = 1,   // every event has size items
+    kPoisson = 2  // Poisson distributed with mean size
+  };
+
   MakeSimpleTree(const std::string &name = "MAKETREE");
-  virtual ~MakeSimpleTree() {}
+  virtual ~MakeSimpleTree();
 
   int Init(PHCompositeNode *topNode);
 
   int process_event(PHCompositeNode *topNode);
 
+  void SetPayload(const PayloadMode mode, const double size = 0) {payloadmode = mode; payloadsize = size;}
+  void SetSeed(const unsigned int i) {seed = i;}
+  // event number of the first event made by this module
+  void SetFirstEvent(const int i) {firstevent = i;}
+
+  // fill the event index (node EVENTINDEX, see anautils/EventIndex.h):
+  // scalars eventnumber and nitems, flag oddevent
+  void FillEventIndex(const bool b) {filleventindex = b;}
+  // by default only odd events are written, with false all events are
+  // written and the selection is only recorded in the oddevent flag
+  void DiscardEvents(const bool b) {discardevents = b;}
+
+  // number of items in event number n
+  int PayloadSize(const int n);
+
  protected:
 
+  // seed for event n, derived from the seed and n
+  unsigned int EventSeed(const int n) const;
+
+  int firstevent;
+  int eventnumber;
+  PayloadMode payloadmode;
+  double payloadsize;
+  unsigned int seed;
+  TRandom3 *random;
+  bool filleventindex;
+  bool discardevents;
+  EventIndex *eventindex;
+  int eventnumberscalar;
+  int nitemsscalar;
+  int oddeventflag;
 
 };
 
 #endif /* MAKESIMPLETREE_H__ */
-
@@ -0,0 +1,152 @@
+#ifndef MYOBJECTPOOL_H__
+#define MYOBJECTPOOL_H__
+// Generic version of MyTClonesArray: a container for many objects of one
+// class per event (tracks, hits, ...). The element class is a template
+// parameter, no more copy and paste for every class you want to store.
+// T needs a default constructor, a Reset() method which sets all data
+// members (the constructor of MySimpleTree just calls Reset()) and a
+// ROOT streamer (ClassDef), so anything derived from PHObject will do.
+//
+// Reset() does not delete the elements, they are kept and handed out again
+// by GetNewItem() in the next event. The storage grows by doubling, so once
+// the largest event has been seen no event does any heap allocation. The
+// MyTClonesArray shrinks back to DEFAULTSIZE in every Reset() and then
+// grows in steps of DEFAULTSIZE, which is a lot of new and delete for
+// events with many objects.
+// The pointers returned by GetNewItem() stay valid until the container is
+// deleted (the elements are never moved).
+//
+// Only the used elements are written. The streamer is hand written since
+// ROOT cannot know which elements are in use. This also means the elements
+// are not split into branches, same as inside a TClonesArray in our DSTs.
+//
+// To store your own class derive from MyObjectPool<YourClass> (see
+// MySimpleTreeArray) and add to your LinkDef.h
+// #pragma link C++ class MyObjectPool<YourClass>-;
+// (the - tells root that we provide the streamer ourselves)
+
+#include <phool/PHObject.h>
+#include <phool/phool.h>
+
+#include <TBuffer.h>
+
+#include <iostream>
+#include <vector>
+
+template <class T>
+class MyObjectPool : public PHObject
+{
+ public:
+  MyObjectPool()
+    : nused(0)
+  {
+  }
+
+  virtual ~MyObjectPool()
+  {
+    for (typename std::vector<T *>::iterator iter = chunks.begin(); iter != chunks.end(); ++iter)
+    {
+      delete[] *iter;
+    }
+  }
+
+  // the elements are kept for the next event
+  void Reset() { nused = 0; }
+
+  T *GetNewItem()
+  {
+    if (nused == items.size())
+    {
+      Grow();
+    }
+    T *item = items[nused++];
+    item->Reset();
+    return item;
+  }
+
+  T *GetItem(const unsigned int i) const
+  {
+    if (i >= nused)
+    {
+      std::cout << PHWHERE << " Index " << i
+                << " out of range, number of entries = " << nused << std::endl;
+      return 0;
+    }
+    return items[i];
+  }
+
+  int Entries() const { return nused; }
+
+  // number of elements which can be handed out without allocating memory
+  unsigned int Capacity() const { return items.size(); }
+
+  // make sure n elements can be handed out without allocating memory
+  void Reserve(const unsigned int n)
+  {
+    while (items.size() < n)
+    {
+      Grow();
+    }
+  }
+
+ protected:
+  // double the capacity, the new elements are constructed once here and
+  // live as long as the container
+  void Grow()
+  {
+    static const unsigned int DEFAULTSIZE = 10;
+    unsigned int n = (items.empty()) ? DEFAULTSIZE : items.size();
+    T *chunk = new T[n];
+    chunks.push_back(chunk);
+    items.reserve(items.size() + n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+      items.push_back(chunk + i);
+    }
+  }
+
+  unsigned int nused;      //! number of elements in use, written by the streamer
+  std::vector<T *> items;  //! all constructed elements, the first nused are in use
+  std::vector<T *> chunks; //! the blocks of memory the elements live in
+
+ private:
+  // the elements belong to this container, no copies
+  MyObjectPool(const MyObjectPool &);
+  MyObjectPool &operator=(const MyObjectPool &);
+
+  ClassDef(MyObjectPool, 1)
+};
+
+template <class T>
+void MyObjectPool<T>::Streamer(TBuffer &buf)
+{
+  // Class() and not IsA(), the latter would be the class deriving from us
+  if (buf.IsReading())
+  {
+    UInt_t start;
+    UInt_t count;
+    buf.ReadVersion(&start, &count);
+    PHObject::Streamer(buf);
+    Int_t n;
+    buf >> n;
+    MyObjectPool<T>::Reset();
+    for (Int_t i = 0; i < n; i++)
+    {
+      GetNewItem()->Streamer(buf);
+    }
+    buf.CheckByteCount(start, count, MyObjectPool<T>::Class());
+  }
+  else
+  {
+    UInt_t count = buf.WriteVersion(MyObjectPool<T>::Class(), kTRUE);
+    PHObject::Streamer(buf);
+    buf << static_cast<Int_t>(nused);
+    for (unsigned int i = 0; i < nused; i++)
+    {
+      items[i]->Streamer(buf);
+    }
+    buf.SetByteCount(count, kTRUE);
+  }
+}
+
+#endif /*MYOBJECTPOOL_H__*/
@@ -0,0 +1,20 @@
+#include "MySimpleTreeArray.h"
+
+ClassImp(MySimpleTreeArray)
+
+using namespace std;
+
+MySimpleTreeArray::MySimpleTreeArray():
+  myeventint(0),
+  myeventfloat(NAN)
+{
+}
+
+void
+MySimpleTreeArray::Reset()
+{
+  myeventint = 0;
+  myeventfloat = NAN;
+  MyObjectPool<MySimpleTree>::Reset();
+  return ;
+}
@@ -0,0 +1,31 @@
+#ifndef MYSIMPLETREEARRAY_H__
+#define MYSIMPLETREEARRAY_H__
+// Drop-in replacement for MyTClonesArray based on the generic
+// MyObjectPool, same methods but no allocations once the largest event
+// was seen. This is all that is needed to store your own class.
+
+#include "MyObjectPool.h"
+#include "MySimpleTree.h"
+
+#include <cmath>
+
+class MySimpleTreeArray : public MyObjectPool<MySimpleTree>
+{
+ public:
+  MySimpleTreeArray();
+  virtual ~MySimpleTreeArray() {}
+
+  void Reset();
+  void MyEventInt(const int i) {myeventint = i;}
+  int MyEventInt() const {return myeventint;}
+  void MyEventFloat(const float f) {myeventfloat = f;}
+  float MyEventFloat() const {return myeventfloat;}
+
+ protected:
+  int myeventint;
+  float myeventfloat;
+
+  ClassDef(MySimpleTreeArray,1)
+};
+
+#endif /*MYSIMPLETREEARRAY_H__*/
@@ -0,0 +1,7 @@
+#ifdef __CINT__
+// the - for the template: MyObjectPool brings its own streamer
+// which writes only the elements in use
+#pragma link C++ class MyObjectPool<MySimpleTree>-;
+#pragma link C++ class MySimpleTreeArray+;
+
+#endif /* __CINT__ */
@@ -0,0 +1,47 @@
+#include "MySimpleTreeColumns.h"
+#include "MySimpleTree.h"
+#include "MySimpleTreeArray.h"
+
+ClassImp(MySimpleTreeColumns)
+
+using namespace std;
+
+MySimpleTreeColumns::MySimpleTreeColumns():
+  myeventint(0),
+  myeventfloat(NAN)
+{
+}
+
+void
+MySimpleTreeColumns::Reset()
+{
+  myeventint = 0;
+  myeventfloat = NAN;
+  myint.clear();
+  myfloat.clear();
+  return ;
+}
+
+void
+MySimpleTreeColumns::AddItem(const int i, const float f)
+{
+  myint.push_back(i);
+  myfloat.push_back(f);
+  return ;
+}
+
+void
+MySimpleTreeColumns::Fill(const MySimpleTreeArray &array)
+{
+  Reset();
+  myeventint = array.MyEventInt();
+  myeventfloat = array.MyEventFloat();
+  myint.reserve(array.Entries());
+  myfloat.reserve(array.Entries());
+  for (int j = 0; j < array.Entries(); j++)
+    {
+      const MySimpleTree *item = array.GetItem(j);
+      AddItem(item->MyInt(), item->MyFloat());
+    }
+  return ;
+}
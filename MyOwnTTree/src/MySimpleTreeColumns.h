@@ -0,0 +1,54 @@
+#ifndef MYSIMPLETREECOLUMNS_H__
+#define MYSIMPLETREECOLUMNS_H__
+// The content of a MySimpleTreeArray stored per member instead of per
+// object: all myint of an event in one array, all myfloat in another.
+// Written to a DST root splits this into one branch per member, so if
+// your analysis only needs myfloat you can switch off everything else
+// and get all myfloat values of an event in one go (see
+// macro/ReadColumnsBenchmark.C). Inside a TClonesArray (or MyObjectPool)
+// every object has to be read in full.
+// The price is that there is no MySimpleTree object to hand out, the
+// values are accessed by index.
+
+#include <phool/PHObject.h>
+
+#include <cmath>
+#include <vector>
+
+class MySimpleTreeArray;
+
+class MySimpleTreeColumns : public PHObject
+{
+ public:
+  MySimpleTreeColumns();
+  virtual ~MySimpleTreeColumns() {}
+
+  // the arrays keep their memory for the next event
+  void Reset();
+
+  void AddItem(const int i, const float f);
+  // copy the content of a MySimpleTreeArray (replaces what is stored)
+  void Fill(const MySimpleTreeArray &array);
+
+  // the larger of the two arrays, a reader might have read only one of them
+  int Entries() const { return (myint.size() > myfloat.size()) ? myint.size() : myfloat.size(); }
+  int MyInt(const unsigned int i) const { return myint[i]; }
+  float MyFloat(const unsigned int i) const { return myfloat[i]; }
+  const std::vector<int> &MyInts() const { return myint; }
+  const std::vector<float> &MyFloats() const { return myfloat; }
+
+  void MyEventInt(const int i) {myeventint = i;}
+  int MyEventInt() const {return myeventint;}
+  void MyEventFloat(const float f) {myeventfloat = f;}
+  float MyEventFloat() const {return myeventfloat;}
+
+ protected:
+  int myeventint;
+  float myeventfloat;
+  std::vector<int> myint;
+  std::vector<float> myfloat;
+
+  ClassDef(MySimpleTreeColumns,1)
+};
+
+#endif /*MYSIMPLETREECOLUMNS_H__*/
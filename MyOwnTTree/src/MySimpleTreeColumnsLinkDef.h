@@ -0,0 +1,5 @@
+#ifdef __CINT__
+// with the + root splits the two vectors into their own branches
+#pragma link C++ class MySimpleTreeColumns+;
+
+#endif /* __CINT__ */
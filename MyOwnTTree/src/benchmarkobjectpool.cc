@@ -0,0 +1,95 @@
+// Compares MyTClonesArray with the MyObjectPool based MySimpleTreeArray.
+// The events ramp up like in MakeSimpleTree (event i has i items), followed
+// by events which all have the largest number of items (the steady state of
+// a real job). For each container the number of heap allocations (counted by
+// replacing the global operator new, which only works in a program of its
+// own) and the time per item are printed.
+//   make benchmarkobjectpool
+//   ./benchmarkobjectpool [events in ramp] [steady state events]
+
+#include "MySimpleTree.h"
+#include "MySimpleTreeArray.h"
+#include "MyTClonesArray.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+  unsigned long nallocations = 0;
+}
+
+void *operator new(size_t size)
+{
+  ++nallocations;
+  void *p = malloc(size ? size : 1);
+  if (!p)
+  {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  free(p);
+}
+
+template <class Container>
+void run(const char *label, const int nramp, const int nsteady)
+{
+  Container container;
+  unsigned long nitems[2] = {0, 0};
+  unsigned long nalloc[2] = {0, 0};
+  double time[2] = {0, 0};
+  for (int phase = 0; phase < 2; phase++)
+  {
+    const unsigned long allocstart = nallocations;
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    const int nevents = (phase == 0) ? nramp : nsteady;
+    for (int i = 0; i < nevents; i++)
+    {
+      const int n = (phase == 0) ? i : nramp;
+      container.Reset();
+      for (int j = 0; j < n; j++)
+      {
+        MySimpleTree *item = container.GetNewItem();
+        item->MyFloat(j);
+        item->MyInt(i);
+      }
+      container.MyEventInt(i);
+      nitems[phase] += n;
+    }
+    time[phase] = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    nalloc[phase] = nallocations - allocstart;
+  }
+  const char *phasename[2] = {"ramp", "steady"};
+  for (int phase = 0; phase < 2; phase++)
+  {
+    cout << label << " " << phasename[phase] << ": " << nitems[phase] << " items, "
+         << nalloc[phase] << " allocations";
+    if (nitems[phase] > 0)
+    {
+      cout << ", " << time[phase] / nitems[phase] << " ns/item";
+    }
+    cout << endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const int nramp = (argc > 1) ? atoi(argv[1]) : 1000;
+  const int nsteady = (argc > 2) ? atoi(argv[2]) : 1000;
+  run<MyTClonesArray>("MyTClonesArray:   ", nramp, nsteady);
+  run<MySimpleTreeArray>("MySimpleTreeArray:", nramp, nsteady);
+  return 0;
+}
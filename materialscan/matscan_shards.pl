@@ -0,0 +1,135 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+use Cwd qw(abs_path);
+use File::Basename;
+use File::Path qw(make_path);
+use Getopt::Long;
+
+# runs a material scan split into shards in parallel root processes, each
+# loads the G4 setup once (Fun4All macro with -1 events) and scans every
+# nshards-th bin with matscan_shard.C. Finished shards are kept, running
+# it again only scans the shards which are missing (crashed, killed) and
+# then merges all of them with merge_matscan.C
+
+my $nshards = 8;
+my $njobs = `nproc 2>/dev/null`;
+chomp $njobs;
+$njobs = 4 if (!$njobs);
+my $macro = 'Fun4All_G4_sPHENIX.C';
+my $outdir = 'matscan_shards';
+my $outputfile = 'matscan.root';
+# bins, minimum and span in deg, the defaults of matscan.C
+my $theta = '1 0.1 360';
+my $phi = '10 0 360';
+GetOptions('nshards=i' => \$nshards, 'jobs=i' => \$njobs, 'macro=s' => \$macro,
+	   'outdir=s' => \$outdir, 'outputfile=s' => \$outputfile,
+	   'theta=s' => \$theta, 'phi=s' => \$phi);
+if ($#ARGV >= 0 || $nshards < 1 || $njobs < 1)
+{
+    print "scans material in parallel shards and merges them\n";
+    print "usage matscan_shards.pl\n";
+    print "--nshards number of shards (default $nshards)\n";
+    print "--jobs number of shards running at the same time (default $njobs)\n";
+    print "--macro Fun4All macro which sets up G4 (default $macro)\n";
+    print "--outdir directory for the shards and logs (default $outdir)\n";
+    print "--outputfile merged scan (default $outputfile)\n";
+    print "--theta \"bins min span\" in deg (default \"$theta\")\n";
+    print "--phi \"bins min span\" in deg (default \"$phi\")\n";
+    print "run it in the directory where the Fun4All macro runs\n";
+    exit(-1);
+}
+my @thetagrid = split(' ',$theta);
+my @phigrid = split(' ',$phi);
+if ($#thetagrid != 2 || $#phigrid != 2)
+{
+    die "--theta and --phi need \"bins min span\"\n";
+}
+
+my $macrodir = dirname(abs_path($0));
+make_path($outdir);
+$outdir = abs_path($outdir);
+
+# the shards of a different grid cannot be reused
+my $grid = "theta $theta phi $phi";
+my $gridfile = sprintf("%s/grid.txt",$outdir);
+if (-f $gridfile)
+{
+    open(F,"$gridfile");
+    my $oldgrid = <F>;
+    close(F);
+    chomp $oldgrid;
+    if ($oldgrid ne $grid)
+    {
+	die "$outdir has shards of \"$oldgrid\", use another --outdir\n";
+    }
+}
+else
+{
+    open(F,">$gridfile");
+    print F "$grid\n";
+    close(F);
+}
+
+my %running = ();
+my @failed = ();
+for (my $shard = 0; $shard < $nshards; $shard++)
+{
+    my $shardfile = sprintf("%s/matscan_shard_%d_of_%d.root",$outdir,$shard,$nshards);
+    if (-f $shardfile)
+    {
+	print "shard $shard already done\n";
+	next;
+    }
+    while (keys %running >= $njobs)
+    {
+	&waitforshard();
+    }
+    my $logfile = sprintf("%s/matscan_shard_%d_of_%d.log",$outdir,$shard,$nshards);
+    my $cmd = sprintf("root.exe -b -q -l '%s(-1)' '%s/matscan_shard.C(%d,%d,\"%s\",%s,%s)' > %s 2>&1",
+		      $macro,$macrodir,$shard,$nshards,$shardfile,
+		      join(',',@thetagrid),join(',',@phigrid),$logfile);
+    my $pid = fork();
+    die "cannot fork: $!\n" if (!defined $pid);
+    if ($pid == 0)
+    {
+	exec($cmd);
+	die "cannot run $cmd\n";
+    }
+    print "started shard $shard (pid $pid), log in $logfile\n";
+    $running{$pid} = $shard;
+}
+while (keys %running > 0)
+{
+    &waitforshard();
+}
+if ($#failed >= 0)
+{
+    print "shards @failed did not finish, check their logs and run this again\n";
+    exit(1);
+}
+my $cmd = sprintf("root.exe -b -q -l '%s/merge_matscan.C(\"%s/matscan_shard_*_of_%d.root\",\"%s\")'",
+		  $macrodir,$outdir,$nshards,$outputfile);
+print "merging: $cmd\n";
+exit(system($cmd) == 0 ? 0 : 1);
+
+# a shard is done when its root file exists, matscan_tree() renames it
+# from .part only after the last bin
+sub waitforshard
+{
+    my $pid = wait();
+    return if ($pid < 0 || !exists $running{$pid});
+    my $shard = $running{$pid};
+    delete $running{$pid};
+    my $shardfile = sprintf("%s/matscan_shard_%d_of_%d.root",$outdir,$shard,$nshards);
+    if (-f $shardfile)
+    {
+	print "shard $shard done\n";
+    }
+    else
+    {
+	print "shard $shard failed\n";
+	push(@failed,$shard);
+    }
+}
@@ -2,7 +2,6 @@
 
 #include <fun4all/Fun4AllReturnCodes.h>
 #include <fun4all/Fun4AllServer.h>
-#include <fun4all/PHTFileServer.h>
 
 #include <phool/PHCompositeNode.h>
 #include <phool/getClass.h>
@@ -13,12 +12,16 @@
 
 #include <g4jets/JetMap.h>
 
+#include <anautils/EtaPhiGrid.h>
+#include <anautils/HistoBuffer.h>
+#include <anautils/OutputPolicy.h>
+
+#include <TBranch.h>
 #include <TFile.h>
 #include <TH1F.h>
 #include <TH2F.h>
 #include <TString.h>
 #include <TTree.h>
-#include <TVector3.h>
 
 #include <algorithm>
 #include <cassert>
@@ -31,9 +34,13 @@ using namespace std;
 
 MyJetAnalysis::MyJetAnalysis(const std::string& recojetname, const std::string& truthjetname, const std::string& outputfilename)
   : SubsysReco("MyJetAnalysis_" + recojetname + "_" + truthjetname)
+  , m_recoJetNode(recojetname)
+  , m_trackMapNode("SvtxTrackMap")
   , m_recoJetName(recojetname)
   , m_truthJetName(truthjetname)
   , m_outputFileName(outputfilename)
+  , m_outputPolicy(new OutputPolicy())
+  , m_outputFile(nullptr)
   , m_etaRange(-1, 1)
   , m_ptRange(5, 100)
   , m_trackJetMatchingRadius(.7)
@@ -55,9 +62,12 @@ MyJetAnalysis::MyJetAnalysis(const std::string& recojetname, const std::string&
   , m_truthE(numeric_limits<float>::signaling_NaN())
   , m_truthPt(numeric_limits<float>::signaling_NaN())
   , m_nMatchedTrack(-1)
+  , m_trackdRBranch(nullptr)
+  , m_trackpTBranch(nullptr)
 {
-  m_trackdR.fill(numeric_limits<float>::signaling_NaN());
-  m_trackpT.fill(numeric_limits<float>::signaling_NaN());
+  // initial capacity, the vectors grow when a jet has more matched tracks
+  m_trackdR.reserve(64);
+  m_trackpT.reserve(64);
 }
 
 MyJetAnalysis::~MyJetAnalysis()
@@ -69,7 +79,7 @@ int MyJetAnalysis::Init(PHCompositeNode* topNode)
   if (Verbosity() >= MyJetAnalysis::VERBOSITY_SOME)
     cout << "MyJetAnalysis::Init - Outoput to " << m_outputFileName << endl;
 
-  PHTFileServer::get().open(m_outputFileName, "RECREATE");
+  m_outputFile = m_outputPolicy->OpenFile(m_outputFileName);
 
   // Histograms
   m_hInclusiveE = new TH1F(
@@ -84,6 +94,9 @@ int MyJetAnalysis::Init(PHCompositeNode* topNode)
       new TH1F(
           "hInclusive_phi",  //
           TString(m_recoJetName) + " inclusive jet #phi;#phi;Jet energy density", 50, -M_PI, M_PI);
+  m_hInclusiveEBuffer.reset(new HistoBuffer(m_hInclusiveE));
+  m_hInclusiveEtaBuffer.reset(new HistoBuffer(m_hInclusiveEta));
+  m_hInclusivePhiBuffer.reset(new HistoBuffer(m_hInclusivePhi));
 
   //Trees
   m_T = new TTree("T", "MyJetAnalysis Tree");
@@ -119,10 +132,12 @@ int MyJetAnalysis::Init(PHCompositeNode* topNode)
   //      //! number of matched tracks
   //      int m_nMatchedTrack;
   m_T->Branch("nMatchedTrack", &m_nMatchedTrack, "nMatchedTrack/I");
-  //      std::array<float, kMaxMatchedTrack> m_trackdR;
-  m_T->Branch("id", m_trackdR.data(), "trackdR[nMatchedTrack]/F");
-  //      std::array<float, kMaxMatchedTrack> m_trackpT;
-  m_T->Branch("id", m_trackpT.data(), "trackpT[nMatchedTrack]/F");
+  //      std::vector<float> m_trackdR;
+  m_trackdRBranch = m_T->Branch("trackdR", m_trackdR.data(), "trackdR[nMatchedTrack]/F");
+  //      std::vector<float> m_trackpT;
+  m_trackpTBranch = m_T->Branch("trackpT", m_trackpT.data(), "trackpT[nMatchedTrack]/F");
+
+  m_outputPolicy->ApplyTo(m_T);
 
   return Fun4AllReturnCodes::EVENT_OK;
 }
@@ -130,19 +145,38 @@ int MyJetAnalysis::Init(PHCompositeNode* topNode)
 int MyJetAnalysis::End(PHCompositeNode* topNode)
 {
   cout << "MyJetAnalysis::End - Outoput to " << m_outputFileName << endl;
-  PHTFileServer::get().cd(m_outputFileName);
+  m_outputFile->cd();
 
+  m_hInclusiveEBuffer->Flush();
+  m_hInclusiveEtaBuffer->Flush();
+  m_hInclusivePhiBuffer->Flush();
   m_hInclusiveE->Write();
   m_hInclusiveEta->Write();
   m_hInclusivePhi->Write();
   m_T->Write();
 
+  // closing the file deletes the histograms and the tree
+  m_outputFile->Close();
+  delete m_outputFile;
+  m_outputFile = nullptr;
+
+  m_outputPolicy->Finish(m_outputFileName);
+
   return Fun4AllReturnCodes::EVENT_OK;
 }
 
+void MyJetAnalysis::setOutputPolicy(const OutputPolicy& policy)
+{
+  *m_outputPolicy = policy;
+}
+
 int MyJetAnalysis::InitRun(PHCompositeNode* topNode)
 {
   m_jetEvalStack = shared_ptr<JetEvalStack>(new JetEvalStack(topNode, m_recoJetName, m_truthJetName));
+  m_trackGrid = shared_ptr<EtaPhiGrid>(new EtaPhiGrid(m_trackJetMatchingRadius));
+
+  m_recoJetNode.Resolve(topNode);
+  m_trackMapNode.Resolve(topNode);
 
   return Fun4AllReturnCodes::EVENT_OK;
 }
@@ -157,7 +191,7 @@ int MyJetAnalysis::process_event(PHCompositeNode* topNode)
   ++m_event;
 
   // interface to jets
-  JetMap* jets = findNode::getClass<JetMap>(topNode, m_recoJetName);
+  JetMap* jets = m_recoJetNode.Get(topNode);
   if (!jets)
   {
     cout
@@ -167,7 +201,7 @@ int MyJetAnalysis::process_event(PHCompositeNode* topNode)
   }
 
   // interface to tracks
-  SvtxTrackMap* trackmap = findNode::getClass<SvtxTrackMap>(topNode, "SvtxTrackMap");
+  SvtxTrackMap* trackmap = m_trackMapNode.Get(topNode);
   if (!trackmap)
   {
     cout
@@ -175,6 +209,31 @@ int MyJetAnalysis::process_event(PHCompositeNode* topNode)
     exit(-1);
   }
 
+  // compute the track kinematics once per event and sort the tracks into
+  // eta-phi cells, each jet then only looks at the tracks in the cells
+  // around its axis
+  m_trackGrid->Reset();
+  m_trackPtBuffer.clear();
+  for (SvtxTrackMap::Iter iter = trackmap->begin();
+       iter != trackmap->end();
+       ++iter)
+  {
+    SvtxTrack* track = iter->second;
+
+    const float px = track->get_px();
+    const float py = track->get_py();
+    const float pz = track->get_pz();
+    const float pt = sqrt(px * px + py * py);
+    // no direction in eta for tracks along the beam axis
+    if (pt <= 0)
+    {
+      continue;
+    }
+
+    m_trackGrid->Add(asinh(pz / pt), atan2(py, px), m_trackPtBuffer.size());
+    m_trackPtBuffer.push_back(pt);
+  }
+
   for (JetMap::Iter iter = jets->begin(); iter != jets->end(); ++iter)
   {
     Jet* jet = iter->second;
@@ -195,12 +254,12 @@ int MyJetAnalysis::process_event(PHCompositeNode* topNode)
     }
 
     // fill histograms
-    assert(m_hInclusiveE);
-    m_hInclusiveE->Fill(jet->get_e());
-    assert(m_hInclusiveEta);
-    m_hInclusiveEta->Fill(jet->get_eta());
-    assert(m_hInclusivePhi);
-    m_hInclusivePhi->Fill(jet->get_phi());
+    assert(m_hInclusiveEBuffer);
+    m_hInclusiveEBuffer->Fill(jet->get_e());
+    assert(m_hInclusiveEtaBuffer);
+    m_hInclusiveEtaBuffer->Fill(jet->get_eta());
+    assert(m_hInclusivePhiBuffer);
+    m_hInclusivePhiBuffer->Fill(jet->get_phi());
 
     // fill trees - jet spectrum
     Jet* truthjet = recoeval->max_truth_jet_by_energy(jet);
@@ -230,38 +289,26 @@ int MyJetAnalysis::process_event(PHCompositeNode* topNode)
     }
 
     // fill trees - jet track matching
-    m_nMatchedTrack = 0;
+    m_trackdR.clear();
+    m_trackpT.clear();
 
-    for (SvtxTrackMap::Iter iter = trackmap->begin();
-         iter != trackmap->end();
-         ++iter)
-    {
-      SvtxTrack* track = iter->second;
-
-      TVector3 v(track->get_px(), track->get_py(), track->get_pz());
-      const double dEta = v.Eta() - m_eta;
-      const double dPhi = v.Phi() - m_phi;
-      const double dR = sqrt(dEta * dEta + dPhi * dPhi);
-
-      if (dR < m_trackJetMatchingRadius)
-      {
-        //matched track to jet
-
-        assert(m_nMatchedTrack < kMaxMatchedTrack);
-
-        m_trackdR[m_nMatchedTrack] = dR;
-        m_trackpT[m_nMatchedTrack] = v.Perp();
-
-        ++m_nMatchedTrack;
-      }
+    m_trackGrid->ForEachWithin(m_eta, m_phi, m_trackJetMatchingRadius, [&](const int itrack, const float dR2) {
+      //matched track to jet
+      m_trackdR.push_back(sqrt(dR2));
+      m_trackpT.push_back(m_trackPtBuffer[itrack]);
+    });
 
-      if (m_nMatchedTrack >= kMaxMatchedTrack)
-      {
-        cout << "MyJetAnalysis::process_event() - reached max track that matching a jet. Quit iterating tracks" << endl;
-        break;
-      }
+    m_nMatchedTrack = m_trackdR.size();
 
-    }  //    for (SvtxTrackMap::Iter iter = trackmap->begin();
+    // the vectors moved if they had to grow for this jet
+    if (m_trackdRBranch->GetAddress() != reinterpret_cast<char*>(m_trackdR.data()))
+    {
+      m_trackdRBranch->SetAddress(m_trackdR.data());
+    }
+    if (m_trackpTBranch->GetAddress() != reinterpret_cast<char*>(m_trackpT.data()))
+    {
+      m_trackpTBranch->SetAddress(m_trackpT.data());
+    }
 
     m_T->Fill();
   }  //   for (JetMap::Iter iter = jets->begin(); iter != jets->end(); ++iter)
@@ -8,11 +8,20 @@
 #include <utility>  // std::pair, std::make_pair
 
 #if ! defined(__CINT__) || defined(__CLING__)
-#include <array>
+#include <anautils/NodeHandle.h>
+
+#include <vector>
 #endif  // #ifndef __CINT__
 
 class PHCompositeNode;
 class JetEvalStack;
+class JetMap;
+class SvtxTrackMap;
+class EtaPhiGrid;
+class HistoBuffer;
+class OutputPolicy;
+class TFile;
+class TBranch;
 class TTree;
 class TH1;
 
@@ -42,6 +51,9 @@ class MyJetAnalysis : public SubsysReco
     m_ptRange.second = high;
   }
 
+  //! set compression, basket size, auto flush and scratch directory of the output
+  void setOutputPolicy(const OutputPolicy &policy);
+
   int Init(PHCompositeNode *topNode);
   int InitRun(PHCompositeNode *topNode);
   int process_event(PHCompositeNode *topNode);
@@ -54,11 +66,21 @@ class MyJetAnalysis : public SubsysReco
   //! cache the jet evaluation modules
   std::shared_ptr<JetEvalStack> m_jetEvalStack;
 
+  //! node handles, resolved once per run
+  NodeHandle<JetMap> m_recoJetNode;
+  NodeHandle<SvtxTrackMap> m_trackMapNode;
+
 
   std::string m_recoJetName;
   std::string m_truthJetName;
   std::string m_outputFileName;
 
+  //! I/O settings for the output file and tree
+  std::shared_ptr<OutputPolicy> m_outputPolicy;
+
+  //! output file, owns the histograms and the tree
+  TFile *m_outputFile;
+
   //! eta range
   std::pair<double, double> m_etaRange;
 
@@ -68,11 +90,22 @@ class MyJetAnalysis : public SubsysReco
   //! max track-jet matching radius
   double m_trackJetMatchingRadius;
 
+  //! eta-phi index of this event's tracks, cell size is the matching radius
+  std::shared_ptr<EtaPhiGrid> m_trackGrid;
+
+  //! pT of this event's tracks, indexed like the entries of m_trackGrid
+  std::vector<float> m_trackPtBuffer;
+
   //! Output histograms
   TH1 *m_hInclusiveE;
   TH1 *m_hInclusiveEta;
   TH1 *m_hInclusivePhi;
 
+  //! the inclusive histograms are filled in batches
+  std::shared_ptr<HistoBuffer> m_hInclusiveEBuffer;
+  std::shared_ptr<HistoBuffer> m_hInclusiveEtaBuffer;
+  std::shared_ptr<HistoBuffer> m_hInclusivePhiBuffer;
+
   //! Output Tree variables
   TTree *m_T;
 
@@ -94,13 +127,15 @@ class MyJetAnalysis : public SubsysReco
   //! number of matched tracks
   int m_nMatchedTrack;
 
-  enum
-  {
-    //! max number of tracks
-    kMaxMatchedTrack = 1000
-  };
-  std::array<float, kMaxMatchedTrack> m_trackdR;
-  std::array<float, kMaxMatchedTrack> m_trackpT;
+  //! matched track dR and pT, the vectors are reused for every jet
+  //! and keep their capacity, so they only grow for the busiest jet
+  std::vector<float> m_trackdR;
+  std::vector<float> m_trackpT;
+
+  //! branches of the matched track arrays, their address has to follow
+  //! the vector storage when the vectors grow
+  TBranch *m_trackdRBranch;
+  TBranch *m_trackpTBranch;
 
 #endif  // #ifndef __CINT__
 };